@@ -0,0 +1,496 @@
+#pragma once
+
+#include <cstdint>
+#include <map>
+#include <string>
+#include <unordered_map>
+#include <vector>
+
+#include "Common.h"
+
+namespace cpu_monitor {
+namespace msg {
+
+/**
+ * compact binary encoding of CpuMsg and ProcessMsg, for clients which ask for it by `set_encoding` "binary"
+ * names are sent once and then referred by index, usages are 16 bit fixed point in 0.01%, rates and sizes are varints
+ * the name tables are dropped by a key frame once most of the names are not used anymore, e.g. threads named `worker-<n>`
+ * a process frame only carries the threads changed since the last frame and the ids of the gone ones
+ * followed by the thread events of gone processes, which a session skipping updates by `every` still has
+ * so the frames of one connection are decoded in order, starting from the key frame sent after `set_encoding`
+ */
+namespace binary {
+
+static const uint8_t Version = 3;
+
+enum FrameType : uint8_t {
+  CPU = 0,
+  PROCESS = 1,
+};
+
+enum FrameFlag : uint8_t {
+  KEY = 1,  // the decoder drops the names and threads it has
+};
+
+inline uint16_t toFixed(float percent) {
+  if (!(percent > 0)) return 0;
+  if (percent >= 655.35f) return UINT16_MAX;
+  return (uint16_t)(percent * 100 + 0.5f);
+}
+
+inline float fromFixed(uint16_t value) {
+  return value / 100.f;
+}
+
+inline uint64_t toCount(float value) {
+  return value > 0 ? (uint64_t)(value + 0.5f) : 0;
+}
+
+/**
+ * a rate which is -1 if not sampled, 0 is kept for it
+ */
+inline uint64_t toOptionalCount(float value) {
+  return value < 0 ? 0 : toCount(value) + 1;
+}
+
+inline float fromOptionalCount(uint64_t value) {
+  return value == 0 ? -1 : (float)(value - 1);
+}
+
+class Writer {
+ public:
+  explicit Writer(std::string& out) : out_(out) {}
+
+  void u8(uint8_t value) {
+    out_.push_back((char)value);
+  }
+
+  void u16(uint16_t value) {
+    u8(value & 0xff);
+    u8(value >> 8);
+  }
+
+  void varint(uint64_t value) {
+    while (value >= 0x80) {
+      u8((uint8_t)(value | 0x80));
+      value >>= 7;
+    }
+    u8((uint8_t)value);
+  }
+
+  void svarint(int64_t value) {
+    varint(((uint64_t)value << 1) ^ (uint64_t)(value >> 63));
+  }
+
+  void bytes(const std::string& value) {
+    varint(value.size());
+    out_.append(value);
+  }
+
+ private:
+  std::string& out_;
+};
+
+/**
+ * reads past the end return 0 and clear ok()
+ */
+class Reader {
+ public:
+  explicit Reader(const std::string& in) : p_((const uint8_t*)in.data()), end_(p_ + in.size()) {}
+
+  bool ok() const {
+    return ok_;
+  }
+
+  uint8_t u8() {
+    if (p_ == end_) {
+      ok_ = false;
+      return 0;
+    }
+    return *p_++;
+  }
+
+  uint16_t u16() {
+    uint16_t low = u8();
+    return low | (uint16_t)(u8() << 8);
+  }
+
+  uint64_t varint() {
+    uint64_t value = 0;
+    for (int shift = 0; shift < 64; shift += 7) {
+      auto byte = u8();
+      value |= (uint64_t)(byte & 0x7f) << shift;
+      if (!(byte & 0x80)) return value;
+    }
+    ok_ = false;
+    return 0;
+  }
+
+  int64_t svarint() {
+    auto value = varint();
+    return (int64_t)(value >> 1) ^ -(int64_t)(value & 1);
+  }
+
+  std::string bytes() {
+    auto len = varint();
+    if (len > (uint64_t)(end_ - p_)) {
+      ok_ = false;
+      return {};
+    }
+    std::string value((const char*)p_, len);
+    p_ += len;
+    return value;
+  }
+
+ private:
+  const uint8_t* p_;
+  const uint8_t* end_;
+  bool ok_ = true;
+};
+
+class Encoder {
+ public:
+  /**
+   * the next frame is a key frame, for a new connection or a client which lost its state
+   */
+  void reset() {
+    names_.clear();
+    sent_.clear();
+    processes_.clear();
+    key_ = true;
+  }
+
+  std::string encode(const CpuMsg& msg) {
+    liveNames_[CPU] = msg.cores.size() + 1;
+    compactNames();
+    std::string out;
+    Writer w(out);
+    writeHeader(w, CPU);
+    w.varint(msg.ave.timestamps);
+    w.varint(msg.cores.size());
+    writeCpu(w, msg.ave);
+    for (const auto& core : msg.cores) {
+      writeCpu(w, core);
+    }
+    return out;
+  }
+
+  std::string encode(const ProcessMsg& msg) {
+    liveNames_[PROCESS] = 0;
+    for (const auto& info : msg.infos) {
+      liveNames_[PROCESS] += 1 + info.thread_infos.size() + info.thread_events.size();
+    }
+    for (const auto& info : msg.gone_infos) {
+      liveNames_[PROCESS] += 1 + info.thread_events.size();
+    }
+    compactNames();
+    std::string out;
+    Writer w(out);
+    writeHeader(w, PROCESS);
+    w.varint(msg.timestamps);
+    w.varint(msg.infos.size());
+
+    std::map<uint64_t, std::unordered_map<uint64_t, ThreadState>> processes;
+    std::vector<const ThreadInfo*> changed;
+    for (const auto& info : msg.infos) {
+      w.varint(info.id);
+      writeName(w, info.name);
+      const auto& mem = info.mem_info;
+      for (auto value : {mem.peak, mem.size, mem.hwm, mem.rss, mem.pss, mem.uss, mem.rss_anon, mem.rss_file, mem.rss_shmem, mem.swap}) {
+        w.varint(value);
+      }
+      const auto& io = info.io_info;
+      for (auto value : {io.rchar, io.wchar, io.read_bytes, io.write_bytes}) {
+        w.varint(toCount(value));
+      }
+
+      auto& last = processes_[info.id];
+      auto& threads = processes[info.id];
+      changed.clear();
+      for (const auto& thread : info.thread_infos) {
+        auto state = toState(thread, nameIndex(thread.name));
+        auto iter = last.find(thread.id);
+        if (iter == last.cend() || !(iter->second == state)) changed.push_back(&thread);
+        threads.emplace(thread.id, state);
+      }
+      w.varint(changed.size());
+      for (auto thread : changed) {
+        const auto& state = threads[thread->id];
+        w.varint(thread->id);
+        writeName(w, state.name, thread->name);
+        w.u16(state.usage);
+        w.varint(state.latencyUs);
+        w.varint(state.minFlt);
+        w.varint(state.majFlt);
+        w.varint(state.ctxSwitches);
+        w.varint(state.involCtxSwitches);
+      }
+      size_t gone = 0;
+      for (const auto& item : last) {
+        if (!threads.count(item.first)) ++gone;
+      }
+      w.varint(gone);
+      for (const auto& item : last) {
+        if (!threads.count(item.first)) w.varint(item.first);
+      }
+
+      writeEvents(w, info.thread_events, msg.timestamps);
+    }
+
+    w.varint(msg.gone_infos.size());
+    for (const auto& info : msg.gone_infos) {
+      w.varint(info.id);
+      writeName(w, info.name);
+      writeEvents(w, info.thread_events, msg.timestamps);
+    }
+    // processes not in the msg are dropped by the decoder too
+    processes_ = std::move(processes);
+    return out;
+  }
+
+ private:
+  struct ThreadState {
+    uint32_t name;
+    uint16_t usage;
+    uint64_t latencyUs;
+    uint64_t minFlt;
+    uint64_t majFlt;
+    uint64_t ctxSwitches;
+    uint64_t involCtxSwitches;
+
+    bool operator==(const ThreadState& o) const {
+      return name == o.name && usage == o.usage && latencyUs == o.latencyUs && minFlt == o.minFlt && majFlt == o.majFlt && ctxSwitches == o.ctxSwitches &&
+             involCtxSwitches == o.involCtxSwitches;
+    }
+  };
+
+  static ThreadState toState(const ThreadInfo& info, uint32_t name) {
+    return ThreadState{name,
+                       toFixed(info.usage),
+                       toCount(info.latency * 1000),
+                       toCount(info.min_flt),
+                       toCount(info.maj_flt),
+                       toOptionalCount(info.ctx_switches),
+                       toOptionalCount(info.invol_ctx_switches)};
+  }
+
+  void writeHeader(Writer& w, FrameType type) {
+    w.u8(Version);
+    w.u8(type);
+    w.u8(key_ ? KEY : 0);
+    key_ = false;
+  }
+
+  /**
+   * names of exited threads are never removed one by one, as the index of a name must stay the same while the decoder has it
+   * so the tables of both sides are dropped by a key frame once they are mostly unused
+   */
+  void compactNames() {
+    if (names_.size() < 2 * (liveNames_[CPU] + liveNames_[PROCESS]) + 1024) return;
+    reset();
+  }
+
+  uint32_t nameIndex(const std::string& name) {
+    auto iter = names_.find(name);
+    if (iter != names_.cend()) return iter->second;
+    auto index = (uint32_t)names_.size();
+    names_.emplace(name, index);
+    sent_.push_back(false);
+    return index;
+  }
+
+  /**
+   * index << 1, or with 1 and followed by the name the first time
+   */
+  void writeName(Writer& w, uint32_t index, const std::string& name) {
+    if (sent_[index]) {
+      w.varint((uint64_t)index << 1);
+      return;
+    }
+    sent_[index] = true;
+    w.varint((uint64_t)index << 1 | 1);
+    w.bytes(name);
+  }
+
+  void writeName(Writer& w, const std::string& name) {
+    writeName(w, nameIndex(name), name);
+  }
+
+  void writeEvents(Writer& w, const std::vector<ThreadEvent>& events, uint64_t timestamps) {
+    w.varint(events.size());
+    for (const auto& event : events) {
+      w.varint(event.id);
+      writeName(w, event.name);
+      w.u8(event.exit);
+      w.svarint((int64_t)(timestamps - event.timestamps));
+    }
+  }
+
+  void writeCpu(Writer& w, const CpuInfo& info) {
+    writeName(w, info.name);
+    w.u8(info.online);
+    w.u16(toFixed(info.usage));
+    w.varint(info.times.size());
+    for (auto time : info.times) {
+      w.u16(time);
+    }
+  }
+
+ private:
+  std::unordered_map<std::string, uint32_t> names_;
+  std::vector<bool> sent_;                                                   // by the index of names_
+  std::map<uint64_t, std::unordered_map<uint64_t, ThreadState>> processes_;  // as sent last time
+  size_t liveNames_[2] = {0, 0};                                             // names at most used by the last frame of each type
+  bool key_ = true;
+};
+
+class Decoder {
+ public:
+  /**
+   * @return false if the frame is malformed or the key frame was not seen, the frames until the next key frame fail too
+   */
+  template <typename Msg>
+  bool decode(const std::string& frame, Msg* msg) {
+    Reader r(frame);
+    if (read(r, msg)) return true;
+    synced_ = false;
+    return false;
+  }
+
+ private:
+  bool read(Reader& r, CpuMsg* msg) {
+    if (!readHeader(r, CPU)) return false;
+    auto timestamps = r.varint();
+    auto num = r.varint();
+    if (!readCpu(r, timestamps, &msg->ave)) return false;
+    msg->cores.clear();
+    for (uint64_t i = 0; i < num && r.ok(); ++i) {
+      msg->cores.emplace_back();
+      if (!readCpu(r, timestamps, &msg->cores.back())) return false;
+    }
+    return r.ok();
+  }
+
+  bool read(Reader& r, ProcessMsg* msg) {
+    if (!readHeader(r, PROCESS)) return false;
+    msg->timestamps = r.varint();
+    auto num = r.varint();
+    msg->infos.clear();
+
+    std::map<uint64_t, std::map<uint64_t, ThreadInfo>> processes;
+    for (uint64_t i = 0; i < num && r.ok(); ++i) {
+      msg->infos.emplace_back();
+      auto& info = msg->infos.back();
+      info.id = r.varint();
+      if (!readName(r, &info.name)) return false;
+      auto& mem = info.mem_info;
+      for (auto value : {&mem.peak, &mem.size, &mem.hwm, &mem.rss, &mem.pss, &mem.uss, &mem.rss_anon, &mem.rss_file, &mem.rss_shmem, &mem.swap}) {
+        *value = r.varint();
+      }
+      mem.timestamps = msg->timestamps;
+      auto& io = info.io_info;
+      for (auto value : {&io.rchar, &io.wchar, &io.read_bytes, &io.write_bytes}) {
+        *value = (float)r.varint();
+      }
+      io.timestamps = msg->timestamps;
+
+      auto& threads = processes[info.id];
+      threads = std::move(processes_[info.id]);
+      auto changed = r.varint();
+      for (uint64_t j = 0; j < changed && r.ok(); ++j) {
+        auto id = r.varint();
+        auto& thread = threads[id];
+        thread.id = id;
+        if (!readName(r, &thread.name)) return false;
+        thread.usage = fromFixed(r.u16());
+        thread.latency = r.varint() / 1000.f;
+        thread.min_flt = (float)r.varint();
+        thread.maj_flt = (float)r.varint();
+        thread.ctx_switches = fromOptionalCount(r.varint());
+        thread.invol_ctx_switches = fromOptionalCount(r.varint());
+      }
+      auto gone = r.varint();
+      for (uint64_t j = 0; j < gone && r.ok(); ++j) {
+        threads.erase(r.varint());
+      }
+      for (auto& item : threads) {
+        item.second.timestamps = msg->timestamps;
+        info.thread_infos.push_back(item.second);
+      }
+
+      if (!readEvents(r, &info.thread_events, msg->timestamps)) return false;
+    }
+
+    auto gone = r.varint();
+    msg->gone_infos.clear();
+    for (uint64_t i = 0; i < gone && r.ok(); ++i) {
+      msg->gone_infos.emplace_back();
+      auto& info = msg->gone_infos.back();
+      info.id = r.varint();
+      if (!readName(r, &info.name)) return false;
+      if (!readEvents(r, &info.thread_events, msg->timestamps)) return false;
+    }
+    if (!r.ok()) return false;
+    processes_ = std::move(processes);
+    return true;
+  }
+
+  bool readHeader(Reader& r, FrameType type) {
+    if (r.u8() != Version || r.u8() != type) return false;
+    if (r.u8() & KEY) {
+      names_.clear();
+      processes_.clear();
+      synced_ = true;
+    }
+    return r.ok() && synced_;
+  }
+
+  bool readEvents(Reader& r, std::vector<ThreadEvent>* events, uint64_t timestamps) {
+    auto num = r.varint();
+    for (uint64_t i = 0; i < num && r.ok(); ++i) {
+      ThreadEvent event;
+      event.id = r.varint();
+      if (!readName(r, &event.name)) return false;
+      event.exit = r.u8() != 0;
+      event.timestamps = timestamps - r.svarint();
+      events->push_back(std::move(event));
+    }
+    return r.ok();
+  }
+
+  bool readName(Reader& r, std::string* name) {
+    auto ref = r.varint();
+    auto index = ref >> 1;
+    if (ref & 1) {
+      // indexes are given in the order of the encoder, which may skip some in a frame
+      if (index > names_.size() + UINT16_MAX) return false;
+      if (index >= names_.size()) names_.resize(index + 1);
+      names_[index] = r.bytes();
+    }
+    if (index >= names_.size()) return false;
+    *name = names_[index];
+    return r.ok();
+  }
+
+  bool readCpu(Reader& r, uint64_t timestamps, CpuInfo* info) {
+    if (!readName(r, &info->name)) return false;
+    info->online = r.u8() != 0;
+    info->usage = fromFixed(r.u16());
+    auto num = r.varint();
+    info->times.clear();
+    for (uint64_t i = 0; i < num && r.ok(); ++i) {
+      info->times.push_back(r.u16());
+    }
+    info->timestamps = timestamps;
+    return r.ok();
+  }
+
+ private:
+  std::vector<std::string> names_;
+  std::map<uint64_t, std::map<uint64_t, ThreadInfo>> processes_;
+  bool synced_ = false;
+};
+
+}  // namespace binary
+}  // namespace msg
+}  // namespace cpu_monitor
@@ -5,6 +5,8 @@
 #include "nlohmann/json.hpp"
 
 #define MSG_SERIALIZE_DEFINE(Type, ...) NLOHMANN_DEFINE_TYPE_NON_INTRUSIVE(Type, __VA_ARGS__)
+// keys missing in the json take the values of a default constructed `Type`
+#define MSG_SERIALIZE_DEFINE_WITH_DEFAULT(Type, ...) NLOHMANN_DEFINE_TYPE_NON_INTRUSIVE_WITH_DEFAULT(Type, __VA_ARGS__)
 
 namespace cpu_monitor {
 
@@ -15,46 +17,234 @@ namespace msg {
 struct CpuInfo {
   std::string name;
   float usage = 0.0f;
+  // percentage of each CpuT category in 0.01% units, in CpuT order, trailing zeros are omitted
+  std::vector<uint16_t> times{};
+  bool online = true;  // false: the core is offline, usage and times are 0
   uint64_t timestamps = 0;
+
+  void setTimes(const float *percents, int num) {
+    times.resize(num);
+    for (int i = 0; i < num; ++i) {
+      times[i] = (uint16_t)(percents[i] * 100 + 0.5f);
+    }
+    while (!times.empty() && times.back() == 0) times.pop_back();
+  }
+
+  float time(int type) const {
+    return type < (int)times.size() ? times[type] / 100.f : 0;
+  }
 };
-MSG_SERIALIZE_DEFINE(CpuInfo, name, usage, timestamps);
+MSG_SERIALIZE_DEFINE_WITH_DEFAULT(CpuInfo, name, usage, times, online, timestamps);
 
 struct CpuMsg {
   CpuInfo ave{};
-  std::vector<CpuInfo> cores{};
+  std::vector<CpuInfo> cores{};  // cores[i] is `cpu<i>`, including offline ones
 };
-MSG_SERIALIZE_DEFINE(CpuMsg, ave, cores);
+MSG_SERIALIZE_DEFINE_WITH_DEFAULT(CpuMsg, ave, cores);
 
 struct ThreadInfo {
   std::string name;
   uint64_t id = 0;
   float usage = 0.0f;
+  float latency = 0.0f;  // ms waited on a run queue during the last interval, 0 if not sampled
+  // per second during the last interval, 0 if not sampled
+  float min_flt = 0.0f;
+  float maj_flt = 0.0f;
+  // -1 if the platform does not report them (apple)
+  float ctx_switches = 0.0f;  // voluntary and involuntary
+  float invol_ctx_switches = 0.0f;
+  uint64_t timestamps = 0;
+};
+MSG_SERIALIZE_DEFINE_WITH_DEFAULT(ThreadInfo, name, id, usage, latency, min_flt, maj_flt, ctx_switches, invol_ctx_switches, timestamps);
+
+struct ThreadEvent {
+  uint64_t id = 0;
+  std::string name;
+  bool exit = false;  // false: birth
   uint64_t timestamps = 0;
 };
-MSG_SERIALIZE_DEFINE(ThreadInfo, name, id, usage, timestamps);
+MSG_SERIALIZE_DEFINE_WITH_DEFAULT(ThreadEvent, id, name, exit, timestamps);
 
 struct MemInfo {
   uint64_t peak = 0;
   uint64_t size = 0;
   uint64_t hwm = 0;
   uint64_t rss = 0;
+  // from smaps_rollup at a lower frequency, the latest values are repeated, 0 if not sampled
+  uint64_t pss = 0;
+  uint64_t uss = 0;
+  uint64_t rss_anon = 0;
+  uint64_t rss_file = 0;
+  uint64_t rss_shmem = 0;
+  uint64_t swap = 0;
   uint64_t timestamps = 0;
 };
-MSG_SERIALIZE_DEFINE(MemInfo, peak, size, hwm, rss, timestamps);
+MSG_SERIALIZE_DEFINE_WITH_DEFAULT(MemInfo, peak, size, hwm, rss, pss, uss, rss_anon, rss_file, rss_shmem, swap, timestamps);
+
+struct IoInfo {
+  // bytes per second during the last interval, 0 if not sampled
+  float rchar = 0.0f;  // read by read(2) and alike, including the page cache, pipes and sockets
+  float wchar = 0.0f;
+  float read_bytes = 0.0f;  // fetched from the storage
+  float write_bytes = 0.0f;
+  uint64_t timestamps = 0;
+};
+MSG_SERIALIZE_DEFINE_WITH_DEFAULT(IoInfo, rchar, wchar, read_bytes, write_bytes, timestamps);
 
 struct ProcessInfo {
   uint64_t id = 0;
   std::string name;
   std::vector<ThreadInfo> thread_infos{};
+  std::vector<ThreadEvent> thread_events{};  // births and deaths since the last msg, including threads shorter than an interval
   MemInfo mem_info{};
+  IoInfo io_info{};
 };
-MSG_SERIALIZE_DEFINE(ProcessInfo, id, name, thread_infos, mem_info);
+MSG_SERIALIZE_DEFINE_WITH_DEFAULT(ProcessInfo, id, name, thread_infos, thread_events, mem_info, io_info);
 
 struct ProcessMsg {
   std::vector<ProcessInfo> infos{};
+  std::vector<ProcessInfo> gone_infos{};  // only id, name and thread_events, of processes not in infos anymore since an update skipped by `every`
+  uint64_t timestamps = 0;
+};
+MSG_SERIALIZE_DEFINE_WITH_DEFAULT(ProcessMsg, infos, gone_infos, timestamps);
+
+struct WatchRule {
+  std::string name;       // like add_name: a comm, or prefixed by "exe:" or "cmdline:"
+  bool children = false;  // also attach the descendants of the matching processes
+};
+MSG_SERIALIZE_DEFINE_WITH_DEFAULT(WatchRule, name, children);
+
+struct WatchMsg {
+  std::vector<WatchRule> rules{};
+};
+MSG_SERIALIZE_DEFINE(WatchMsg, rules);
+
+struct CgroupInfo {
+  std::string path;  // relative to the cgroup v2 mount point
+  // percent of one cpu during the last interval
+  float usage = 0.0f;
+  float user = 0.0f;
+  float system = 0.0f;
+  float quota = 0.0f;  // cpus allowed by cpu.max, 0: no limit
+  // during the last interval
+  uint64_t nr_periods = 0;
+  uint64_t nr_throttled = 0;
+  float throttled_ms = 0.0f;
+  // kB, mem_max is 0 if there is no limit
+  uint64_t mem_current = 0;
+  uint64_t mem_max = 0;
+  uint64_t anon = 0;
+  uint64_t file = 0;
+  uint64_t kernel = 0;
+  uint64_t shmem = 0;
+  // memory.events, totals
+  uint64_t high_events = 0;
+  uint64_t max_events = 0;
+  uint64_t oom_events = 0;
+  uint64_t oom_kills = 0;
+  uint64_t timestamps = 0;
+};
+MSG_SERIALIZE_DEFINE(CgroupInfo, path, usage, user, system, quota, nr_periods, nr_throttled, throttled_ms, mem_current, mem_max, anon, file, kernel,
+                     shmem, high_events, max_events, oom_events, oom_kills, timestamps);
+
+struct CgroupMsg {
+  std::vector<CgroupInfo> infos{};
+  uint64_t timestamps = 0;
+};
+MSG_SERIALIZE_DEFINE(CgroupMsg, infos, timestamps);
+
+struct PressureInfo {
+  std::string resource;  // cpu, memory or io
+  std::string cgroup;    // empty: the system
+  // percent of the time, averages over 10s, 60s and 300s
+  float some_avg10 = 0.0f;
+  float some_avg60 = 0.0f;
+  float some_avg300 = 0.0f;
+  float full_avg10 = 0.0f;
+  float full_avg60 = 0.0f;
+  float full_avg300 = 0.0f;
+  // stalled during the last interval
+  float some_ms = 0.0f;
+  float full_ms = 0.0f;
+  uint64_t timestamps = 0;
+};
+MSG_SERIALIZE_DEFINE(PressureInfo, resource, cgroup, some_avg10, some_avg60, some_avg300, full_avg10, full_avg60, full_avg300, some_ms, full_ms,
+                     timestamps);
+
+struct PressureMsg {
+  std::vector<PressureInfo> infos{};
   uint64_t timestamps = 0;
 };
-MSG_SERIALIZE_DEFINE(ProcessMsg, infos, timestamps);
+MSG_SERIALIZE_DEFINE(PressureMsg, infos, timestamps);
+
+struct PressureRule {
+  std::string resource;  // cpu, memory or io
+  std::string cgroup;    // empty: the system
+  bool full = false;     // false: some
+  uint32_t stall_ms = 0;
+  uint32_t window_ms = 0;  // 500 to 10000, a multiple of 2000 without CAP_SYS_RESOURCE
+};
+MSG_SERIALIZE_DEFINE_WITH_DEFAULT(PressureRule, resource, cgroup, full, stall_ms, window_ms);
+
+struct PressureRuleMsg {
+  std::vector<PressureRule> rules{};
+};
+MSG_SERIALIZE_DEFINE(PressureRuleMsg, rules);
+
+struct PressureEvent {
+  PressureRule rule{};
+  PressureInfo info{};  // sampled when the stall is reported, the interval is since the last update
+  uint64_t timestamps = 0;
+};
+MSG_SERIALIZE_DEFINE(PressureEvent, rule, info, timestamps);
+
+struct TopProcess {
+  uint64_t id = 0;
+  std::string name;
+  float usage = 0.0f;  // percent of one cpu
+  uint64_t rss = 0;    // kB
+  uint32_t threads = 0;
+};
+MSG_SERIALIZE_DEFINE(TopProcess, id, name, usage, rss, threads);
+
+struct TopThread {
+  uint64_t pid = 0;
+  uint64_t id = 0;
+  std::string name;
+  float usage = 0.0f;  // percent of one cpu
+};
+MSG_SERIALIZE_DEFINE(TopThread, pid, id, name, usage);
+
+struct TopMsg {
+  // descending, of all processes and threads of the system
+  std::vector<TopProcess> cpu{};
+  std::vector<TopProcess> rss{};
+  std::vector<TopThread> threads{};
+  uint64_t process_num = 0;
+  uint64_t thread_num = 0;
+  uint64_t timestamps = 0;
+};
+MSG_SERIALIZE_DEFINE(TopMsg, cpu, rss, threads, process_num, thread_num, timestamps);
+
+struct TickInfo {
+  float interval_ms = 0.0f;
+  float late_ms = 0.0f;  // from the deadline of this update to its start
+  float work_ms = 0.0f;  // of the last update
+  uint64_t missed = 0;   // updates skipped since the last msg, because an update took longer than the interval
+  uint64_t missed_total = 0;
+  uint64_t timestamps = 0;
+};
+MSG_SERIALIZE_DEFINE(TickInfo, interval_ms, late_ms, work_ms, missed, missed_total, timestamps);
+
+struct Subscription {
+  // names of the msgs to receive, e.g. on_cpu_msg, on_process_msg, /plugin/meminfo, empty: all
+  std::vector<std::string> streams{};
+  std::vector<uint64_t> pids{};  // processes of on_process_msg, empty: all
+  std::vector<uint64_t> tids{};  // threads of on_process_msg, empty: all
+  bool threads = true;           // false: on_process_msg without threads and thread events
+  uint32_t every = 1;            // one msg of every N updates, pressure events are not skipped
+};
+MSG_SERIALIZE_DEFINE_WITH_DEFAULT(Subscription, streams, pids, tids, threads, every);
 
 struct PluginMsgMalloc {
   int pid;
@@ -1,19 +1,35 @@
+#include <sys/resource.h>
 #include <unistd.h>
 
 #include <algorithm>
+#include <atomic>
+#include <cstdarg>
+#include <cstring>
+#include <list>
 #include <memory>
 #include <thread>
+#include <utility>
 
+#include "BinaryMsg.h"
+#include "CgroupMonitor.h"
 #include "Common.h"
 #include "CpuMonitor.h"
 #include "MemMonitor.h"
-#include "TaskMonitor.h"
+#include "PressureMonitor.h"
+#include "ProcEvents.h"
+#include "ProcessIndex.h"
+#include "ProcessTaskSampler.h"
+#include "TaskTable.h"
+#include "TopScanner.h"
 #include "Utils.h"
 #include "asio.hpp"
 #include "asio_net/rpc_server.hpp"
 #include "log.h"
+#include "utils/async_log.h"
 #include "utils/file_utils.h"
+#include "utils/spsc_queue.h"
 #include "utils/string_utils.h"
+#include "utils/tick_timer.h"
 #include "utils/time_utils.h"
 #include "version.h"
 
@@ -23,31 +39,130 @@ using namespace cpu_monitor;
 struct {
   std::string all_names;
   std::string all_pids;
-  uint32_t d_update_interval_ms = 1000;
+  std::string all_cgroups;
+  std::string w_watch_names;
+  bool f_watch_children = false;
+  float d_update_interval_ms = 1000;
+  bool q_quiet = false;
   bool s_run_server = false;
   uint32_t s_server_port = 8088;
   bool c_only_monitor_cpu = false;
+  bool t_use_taskstats = false;
+  bool r_use_schedstat = false;
+  uint32_t m_mem_rollup_interval_ms = 0;  // 0: off
+  bool e_pressure = false;
+  uint32_t a_top_num = 0;  // 0: off
+  std::string e_pressure_triggers;
+  int b_sample_cpu = -1;           // -1: not pinned
+  int F_sample_fifo_priority = 0;  // 0: not realtime
 } s_argv;
 
-// main logic
+// main logic, all sampling state below is only touched by the thread running it
 static std::unique_ptr<asio::io_context> s_context;
-static std::unique_ptr<asio::steady_timer> s_timer_update;
+static std::unique_ptr<utils::TickTimer> s_timer_update;
+static msg::TickInfo s_tick_info;  // missed is accumulated until it is sent
+static std::thread s_sample_thread;
 
-// rpc
+// rpc, on its own thread with -s so a slow client never delays sampling
+static std::unique_ptr<asio::io_context> s_net_context;
 static std::unique_ptr<asio_net::rpc_server> s_rpc_server;
-static std::shared_ptr<rpc_core::rpc> s_rpc;
+
+// msgs sent every update, or as they come for pressure events, a session subscribes to some of them
+enum StreamFlag : uint32_t {
+  STREAM_CPU = 1 << 0,
+  STREAM_TOP = 1 << 1,
+  STREAM_PROCESS = 1 << 2,
+  STREAM_CGROUP = 1 << 3,
+  STREAM_PRESSURE = 1 << 4,
+  STREAM_PRESSURE_EVENT = 1 << 5,
+  STREAM_TICK = 1 << 6,
+  STREAM_PLUGIN_MALLOC = 1 << 7,
+  STREAM_PLUGIN_MEMINFO = 1 << 8,
+  STREAM_ALL = (1 << 9) - 1,
+};
+static const std::map<std::string, uint32_t> StreamNames = {
+    {"on_cpu_msg", STREAM_CPU},
+    {"on_top_msg", STREAM_TOP},
+    {"on_process_msg", STREAM_PROCESS},
+    {"on_cgroup_msg", STREAM_CGROUP},
+    {"on_pressure_msg", STREAM_PRESSURE},
+    {"on_pressure_event", STREAM_PRESSURE_EVENT},
+    {"on_tick_msg", STREAM_TICK},
+    {"/plugin/malloc", STREAM_PLUGIN_MALLOC},
+    {"/plugin/meminfo", STREAM_PLUGIN_MEMINFO},
+};
+
+// a connected client, on the network thread
+struct Session {
+  std::shared_ptr<rpc_core::rpc> rpc;
+  msg::Subscription subscription{};  // pids and tids sorted
+  uint32_t streams = STREAM_ALL;
+  uint64_t updates = 0;  // since the subscription, for `every`
+  std::map<uint64_t, msg::ProcessInfo> threadEvents;  // of the updates skipped by `every`, by pid
+  // cpu and process msgs are json, or binary after the client asks by set_encoding
+  bool binaryEncoding = false;
+  msg::binary::Encoder binaryEncoder;
+};
+static std::list<std::shared_ptr<Session>> s_sessions;
+// streams of all sessions, the sampling thread does not build the msgs nobody wants
+static std::atomic<uint32_t> s_streams_wanted{0};
+
+// msgs of one update, built by the sampling thread and sent by the network thread
+struct Snapshot {
+  std::unique_ptr<msg::CpuMsg> cpu;
+  std::unique_ptr<msg::TopMsg> top;
+  std::unique_ptr<msg::ProcessMsg> process;
+  std::unique_ptr<msg::CgroupMsg> cgroup;
+  std::unique_ptr<msg::PressureMsg> pressure;
+  std::unique_ptr<msg::PressureEvent> pressureEvent;
+  std::unique_ptr<msg::TickInfo> tick;  // set for the snapshots of updates
+  std::vector<msg::PluginMsgMalloc> mallocs;
+  std::unique_ptr<msg::PluginMsgMemInfo> memInfo;
+};
+static utils::SpscQueue<std::unique_ptr<Snapshot>, 64> s_snapshots;
+static std::atomic<bool> s_snapshots_posted{false};
+static uint64_t s_snapshots_dropped = 0;
 
 // cpu monitor
 static std::unique_ptr<CpuMonitor> s_monitor_cpu;
-static const auto s_total_time_impl = [] {
-  return s_monitor_cpu->ave->totalTime / s_monitor_cpu->cores.size();
-};
 
-using MonitorTasks = std::vector<std::unique_ptr<TaskMonitor>>;
+// top processes and threads of the system, with -a
+static std::unique_ptr<TopScanner> s_top_scanner;
+
+// thread births and deaths pushed by the kernel, fallback to listing /proc/<pid>/task every update
+static std::unique_ptr<ProcEvents> s_proc_events;
+static std::unique_ptr<asio::posix::stream_descriptor> s_proc_events_stream;
+static bool s_proc_events_resync = false;
+
+// names of all processes for add_name, kept by proc events between the listings of /proc
+static std::unique_ptr<ProcessIndex> s_process_index;
+static bool s_process_index_list = true;
+// without proc events execs are not seen, a process indexed between fork and exec keeps the names of its parent
+// so all names are read again once in a while
+static const uint64_t ProcessIndexRefreshNs = 10ULL * 1000000000;
+static uint64_t s_process_index_refresh_ns = 0;
+
+// names to keep monitoring across restarts, the processes are attached as soon as the index reads them
+struct WatchRule {
+  ProcessIndex::Matcher matcher;  // compiled once, matched against the new processes of every index update
+  bool children;                  // also attach the descendants
+};
+static std::map<std::string, WatchRule> s_watch_rules;
 
 struct ProcessValue {
-  MonitorTasks tasks;
+  std::unique_ptr<ProcessTaskSampler> sampler;
+  TaskTable tasks;  // kept up to date by proc events between samples
+  std::unique_ptr<MemMonitor> mem;
   MemMonitor::Usage memUsage{};
+  MemMonitor::Rollup memRollup{};
+  uint64_t memRollupTimestampNs = 0;  // of the last successful read, 0: not read yet
+  uint64_t memRollupTryNs = 0;        // of the last read
+  bool memRollupFailed = false;       // warned already
+  uint64_t intervalNs = 0;     // of the last sample
+  msg::IoInfo io{};            // rates of the last sample
+  std::vector<TaskId_t> tids;  // tids to sample when they are tracked by proc events
+  std::vector<msg::ThreadEvent> threadEvents;  // not sent yet
+  std::string watch;                           // name of the watch rule that attached it
 };
 struct ProcessKey {
   PID_t pid;
@@ -60,19 +175,148 @@ struct ProcessKey {
 using MonitorPids = std::map<ProcessKey, ProcessValue>;
 static MonitorPids s_monitor_pids;
 
+// pressure stall information of cpu, memory and io, sampled every update with -e
+struct PressureValue {
+  std::unique_ptr<PressureMonitor> monitor;
+  PressureMonitor::Sample sample{};
+  msg::PressureInfo info{};  // of the last interval
+};
+static std::vector<PressureValue> s_monitor_pressure;
+
+// cgroup v2 of containers, by the path relative to the mount point
+struct CgroupValue {
+  std::unique_ptr<CgroupMonitor> monitor;
+  CgroupMonitor::Sample sample{};
+  uint64_t timestampNs = 0;             // of the last sample
+  msg::CgroupInfo info{};               // of the last interval
+  std::vector<PressureValue> pressure;  // with -e
+};
+static std::map<std::string, CgroupValue> s_monitor_cgroups;
+
+// stalls reported by the kernel as soon as they go over a threshold, without waiting for the next update
+struct PressureTriggerValue {
+  msg::PressureRule rule;
+  std::unique_ptr<PressureTrigger> trigger;
+  std::unique_ptr<asio::posix::stream_descriptor> stream;
+  PressureValue pressure;  // sampled when a stall is reported
+};
+static std::map<std::string, PressureTriggerValue> s_pressure_triggers;
+
 static bool addMonitorPid(PID_t pid);
 static bool addMonitorPid(const std::string& pid);
 static bool addMonitorPidByName(const std::string& name);
+static std::vector<PID_t> findPidsByName(const std::string& name);
+static bool addWatch(const msg::WatchRule& rule);
+static bool addMonitorCgroup(const std::string& path);
+static bool delWatch(const std::string& name);
+static std::string pressureRuleKey(const msg::PressureRule& rule);
+static bool addPressureTrigger(const msg::PressureRule& rule);
+static void runApp();
 
-static void initRpcTask() {
-  using namespace rpc_core;
-  s_rpc = rpc::create();
+/**
+ * rpc handlers which touch the sampling state run on the sampling thread, the response is sent from the network thread
+ * the network thread never waits, a slow handler e.g. add_name listing /proc delays no snapshots of the other sessions
+ */
+template <typename Req, typename Func>
+static void subscribeOnSampler(const std::shared_ptr<rpc_core::rpc>& rpc, const char* cmd, Func func) {
+  using Rsp = decltype(func(std::declval<const Req&>()));
+  rpc->subscribe(cmd, [func](const rpc_core::request_response<Req, Rsp>& rr) {
+    // never runs once the sampling context is stopped on exit, the client times out then
+    asio::post(*s_context, [func, rr] {
+      auto rsp = std::make_shared<Rsp>(func(rr->req));
+      asio::post(*s_net_context, [rr, rsp] {
+        rr->rsp(std::move(*rsp));
+      });
+    });
+  });
+}
 
-  s_rpc->subscribe("get_version", []() -> std::string {
+/**
+ * for handlers without a request, the empty payload is taken as an empty string
+ */
+template <typename Func>
+static void subscribeOnSampler(const std::shared_ptr<rpc_core::rpc>& rpc, const char* cmd, Func func) {
+  subscribeOnSampler<std::string>(rpc, cmd, [func](const std::string&) {
+    return func();
+  });
+}
+
+/**
+ * samples on the terminal, written by the async log so the sampling thread never waits for stdout
+ */
+__attribute__((format(printf, 1, 2))) static void print(const char* fmt, ...) {
+  if (s_argv.q_quiet) return;
+  va_list args;
+  va_start(args, fmt);
+  utils::AsyncLog::instance().vprint(fmt, args);
+  va_end(args);
+}
+
+static uint64_t steadyNowNs() {
+  return std::chrono::duration_cast<std::chrono::nanoseconds>(std::chrono::steady_clock::now().time_since_epoch()).count();
+}
+
+static void updateStreamsWanted() {
+  uint32_t streams = 0;
+  for (const auto& session : s_sessions) {
+    streams |= session->streams;
+  }
+  s_streams_wanted = streams;
+}
+
+static void initRpcTask(const std::shared_ptr<Session>& session) {
+  auto& rpc = session->rpc;
+  std::weak_ptr<Session> ws = session;
+
+  rpc->subscribe("get_version", []() -> std::string {
     return CPU_MONITOR_VERSION;
   });
 
-  s_rpc->subscribe("add_pid", [](const std::string& pid) -> std::string {
+  // not on the sampling thread, the session belongs to the network thread
+  rpc->subscribe("set_encoding", [ws](const std::string& encoding) -> std::string {
+    LOGD("set_encoding: %s", encoding.c_str());
+    auto session = ws.lock();
+    if (!session) return "closed";
+    if (encoding == "json") {
+      session->binaryEncoding = false;
+    } else if (encoding == "binary") {
+      session->binaryEncoding = true;
+      session->binaryEncoder.reset();
+    } else {
+      return "unsupported encoding";
+    }
+    return "ok";
+  });
+
+  rpc->subscribe("set_subscription", [ws](const msg::Subscription& subscription) -> std::string {
+    auto session = ws.lock();
+    if (!session) return "closed";
+    uint32_t streams = subscription.streams.empty() ? STREAM_ALL : 0;
+    for (const auto& name : subscription.streams) {
+      auto iter = StreamNames.find(name);
+      if (iter == StreamNames.cend()) return "unknown stream: " + name;
+      streams |= iter->second;
+    }
+    LOGD("set_subscription: streams: 0x%x, pids: %zu, tids: %zu, threads: %d, every: %u", streams, subscription.pids.size(),
+         subscription.tids.size(), subscription.threads, subscription.every);
+    session->subscription = subscription;
+    auto& sub = session->subscription;
+    std::sort(sub.pids.begin(), sub.pids.end());
+    std::sort(sub.tids.begin(), sub.tids.end());
+    if (sub.every == 0) sub.every = 1;
+    session->streams = streams;
+    session->updates = 0;
+    session->threadEvents.clear();
+    updateStreamsWanted();
+    return "ok";
+  });
+
+  rpc->subscribe("get_subscription", [ws] {
+    auto session = ws.lock();
+    return session ? session->subscription : msg::Subscription{};
+  });
+
+  subscribeOnSampler<std::string>(rpc, "add_pid", [](const std::string& pid) -> std::string {
     LOGD("add_pid: %s", pid.c_str());
 
     auto iter = std::find_if(s_monitor_pids.begin(), s_monitor_pids.end(), [&](const auto& item) {
@@ -89,7 +333,7 @@ static void initRpcTask() {
     }
   });
 
-  s_rpc->subscribe("del_pid", [](const std::string& pid) -> std::string {
+  subscribeOnSampler<std::string>(rpc, "del_pid", [](const std::string& pid) -> std::string {
     LOGD("del_pid: %s", pid.c_str());
     auto iter = std::find_if(s_monitor_pids.begin(), s_monitor_pids.end(), [&](const auto& item) {
       return std::to_string(item.first.pid) == pid;
@@ -102,12 +346,13 @@ static void initRpcTask() {
     }
   });
 
-  s_rpc->subscribe("add_name", [](const std::string& name) -> std::string {
+  subscribeOnSampler<std::string>(rpc, "add_name", [](const std::string& name) -> std::string {
     LOGD("add_name: %s", name.c_str());
-    auto iter = std::find_if(s_monitor_pids.begin(), s_monitor_pids.end(), [&](const auto& item) {
-      return item.first.name == name;
+    auto pids = findPidsByName(name);
+    bool allAdded = !pids.empty() && std::all_of(pids.cbegin(), pids.cend(), [](PID_t pid) {
+      return s_monitor_pids.count(ProcessKey{pid, {}}) != 0;
     });
-    if (iter != s_monitor_pids.cend()) {
+    if (allAdded) {
       return "already added";
     }
 
@@ -118,20 +363,129 @@ static void initRpcTask() {
     }
   });
 
-  s_rpc->subscribe("del_name", [](const std::string& name) -> std::string {
+  subscribeOnSampler<std::string>(rpc, "del_name", [](const std::string& name) -> std::string {
     LOGD("del_name: %s", name.c_str());
-    auto iter = std::find_if(s_monitor_pids.begin(), s_monitor_pids.end(), [&](const auto& item) {
-      return item.first.name == name;
-    });
-    if (iter != s_monitor_pids.cend()) {
-      s_monitor_pids.erase(iter);
+    // processes exited already are not in the index, match them by the name they were added with
+    auto pids = findPidsByName(name);
+    auto query = ProcessIndex::Query::parse(name);
+    size_t erased = 0;
+    for (auto iter = s_monitor_pids.begin(); iter != s_monitor_pids.end();) {
+      auto& key = iter->first;
+      bool match = std::binary_search(pids.cbegin(), pids.cend(), key.pid);
+      match |= query.field == ProcessIndex::Field::COMM && key.name == query.pattern;
+      if (match) {
+        iter = s_monitor_pids.erase(iter);
+        ++erased;
+      } else {
+        ++iter;
+      }
+    }
+    if (erased) {
       return "ok";
     } else {
       return "no such name";
     }
   });
 
-  s_rpc->subscribe("get_added_pids", [] {
+  subscribeOnSampler<msg::WatchRule>(rpc, "add_watch", [](const msg::WatchRule& rule) -> std::string {
+    LOGD("add_watch: %s, children: %d", rule.name.c_str(), rule.children);
+    if (s_watch_rules.count(rule.name)) {
+      return "already added";
+    }
+    if (!addWatch(rule)) {
+      return "invalid pattern";
+    }
+    return "ok";
+  });
+
+  subscribeOnSampler<std::string>(rpc, "del_watch", [](const std::string& name) -> std::string {
+    LOGD("del_watch: %s", name.c_str());
+    if (delWatch(name)) {
+      return "ok";
+    } else {
+      return "no such watch";
+    }
+  });
+
+  subscribeOnSampler(rpc, "get_watches", [] {
+    msg::WatchMsg msg;
+    for (const auto& item : s_watch_rules) {
+      msg::WatchRule rule;
+      rule.name = item.first;
+      rule.children = item.second.children;
+      msg.rules.push_back(std::move(rule));
+    }
+    return msg;
+  });
+
+  subscribeOnSampler<std::string>(rpc, "add_cgroup", [](const std::string& path) -> std::string {
+    LOGD("add_cgroup: %s", path.c_str());
+    if (s_monitor_cgroups.count(path)) {
+      return "already added";
+    }
+    if (addMonitorCgroup(path)) {
+      return "ok";
+    } else {
+      return "no such cgroup";
+    }
+  });
+
+  subscribeOnSampler<std::string>(rpc, "del_cgroup", [](const std::string& path) -> std::string {
+    LOGD("del_cgroup: %s", path.c_str());
+    if (s_monitor_cgroups.erase(path)) {
+      return "ok";
+    } else {
+      return "no such cgroup";
+    }
+  });
+
+  subscribeOnSampler(rpc, "get_added_cgroups", [] {
+    msg::CgroupMsg msg;
+    for (const auto& item : s_monitor_cgroups) {
+      msg::CgroupInfo info;
+      info.path = item.first;
+      msg.infos.push_back(std::move(info));
+    }
+    return msg;
+  });
+
+  subscribeOnSampler<msg::PressureRule>(rpc, "add_pressure_trigger", [](const msg::PressureRule& rule) -> std::string {
+    LOGD("add_pressure_trigger: %s", pressureRuleKey(rule).c_str());
+    if (s_pressure_triggers.count(pressureRuleKey(rule))) {
+      return "already added";
+    }
+    if (addPressureTrigger(rule)) {
+      return "ok";
+    } else {
+      return std::string("failed: ") + strerror(errno);
+    }
+  });
+
+  subscribeOnSampler<msg::PressureRule>(rpc, "del_pressure_trigger", [](const msg::PressureRule& rule) -> std::string {
+    LOGD("del_pressure_trigger: %s", pressureRuleKey(rule).c_str());
+    if (s_pressure_triggers.erase(pressureRuleKey(rule))) {
+      return "ok";
+    } else {
+      return "no such trigger";
+    }
+  });
+
+  subscribeOnSampler(rpc, "get_pressure_triggers", [] {
+    msg::PressureRuleMsg msg;
+    for (const auto& item : s_pressure_triggers) {
+      msg.rules.push_back(item.second.rule);
+    }
+    return msg;
+  });
+
+  subscribeOnSampler<std::string>(rpc, "set_top", [](const std::string& num) -> std::string {
+    LOGD("set_top: %s", num.c_str());
+    s_argv.a_top_num = std::strtoul(num.c_str(), nullptr, 10);
+    s_top_scanner = s_argv.a_top_num ? std::make_unique<TopScanner>(s_argv.a_top_num) : nullptr;
+    return "ok";
+  });
+
+  subscribeOnSampler(rpc, "get_added_pids", [] {
     msg::ProcessMsg msg;
     for (const auto& monitorPid : s_monitor_pids) {
       auto& id = monitorPid.first;
@@ -144,53 +498,54 @@ static void initRpcTask() {
   });
 }
 
-static void sendPluginsInfos() {
-  if (!s_rpc) return;
+static void collectPluginsInfos(Snapshot& snapshot, uint32_t streams) {
   auto timestampsNow = utils::getTimestamps();
 
   // malloc infos of pids
-  for (const auto& item : s_monitor_pids) {
-    auto pid = item.first.pid;
+  if (streams & STREAM_PLUGIN_MALLOC) {
+    for (const auto& item : s_monitor_pids) {
+      auto pid = item.first.pid;
 
-    char filePath[64];
-    snprintf(filePath, sizeof(filePath), "/tmp/cpu_monitor/%d/malloc", pid);
+      char filePath[64];
+      snprintf(filePath, sizeof(filePath), "/tmp/cpu_monitor/%d/malloc", pid);
 
-    bool file_ok;
-    auto text = file_utils::read_text_file(filePath, &file_ok);
-    if (file_ok) {
-      msg::PluginMsgMalloc msg;
-      msg.pid = pid;
-      msg.text = std::move(text);
-      msg.timestamps = timestampsNow;
-      s_rpc->cmd("/plugin/malloc")->msg(msg)->call();
+      bool file_ok;
+      auto text = file_utils::read_text_file(filePath, &file_ok);
+      if (file_ok) {
+        msg::PluginMsgMalloc msg;
+        msg.pid = pid;
+        msg.text = std::move(text);
+        msg.timestamps = timestampsNow;
+        snapshot.mallocs.push_back(std::move(msg));
+      }
     }
   }
 
   // /proc/meminfo
-  {
+  if (streams & STREAM_PLUGIN_MEMINFO) {
     bool file_ok;
     auto text = file_utils::read_text_file("/proc/meminfo", &file_ok);
     if (file_ok) {
       msg::PluginMsgMemInfo msg;
       msg.text = std::move(text);
       msg.timestamps = timestampsNow;
-      s_rpc->cmd("/plugin/meminfo")->msg(msg)->call();
+      snapshot.memInfo = std::make_unique<msg::PluginMsgMemInfo>(std::move(msg));
     }
   }
 }
 
-static void sendNowInfos() {
-  if (!s_rpc) return;
+static void collectNowInfos(Snapshot& snapshot, uint32_t streams) {
   auto timestampsNow = utils::getTimestamps();
 
   // cpu info
-  {
+  if (streams & STREAM_CPU) {
     msg::CpuMsg msg;
     // ave
     {
       msg::CpuInfo info;
       info.name = s_monitor_cpu->ave->name;
       info.usage = s_monitor_cpu->ave->usage;
+      info.setTimes(s_monitor_cpu->ave->times, CpuT::TYPE_NUM);
       info.timestamps = timestampsNow;
       msg.ave = std::move(info);
     }
@@ -199,16 +554,50 @@ static void sendNowInfos() {
       msg::CpuInfo info;
       info.name = core->name;
       info.usage = core->usage;
+      info.setTimes(core->times, CpuT::TYPE_NUM);
+      info.online = core->online;
       info.timestamps = timestampsNow;
       msg.cores.push_back(std::move(info));
     }
-    s_rpc->cmd("on_cpu_msg")->msg(msg)->call();
+    snapshot.cpu = std::make_unique<msg::CpuMsg>(std::move(msg));
+  }
+
+  // top info
+  if (s_top_scanner && (streams & STREAM_TOP)) {
+    msg::TopMsg msg;
+    auto toMsg = [](const TopScanner::Process& process) {
+      msg::TopProcess info;
+      info.id = process.pid;
+      info.name = process.name;
+      info.usage = process.usage;
+      info.rss = process.rss;
+      info.threads = process.threads;
+      return info;
+    };
+    for (const auto& process : s_top_scanner->topCpu) {
+      msg.cpu.push_back(toMsg(process));
+    }
+    for (const auto& process : s_top_scanner->topRss) {
+      msg.rss.push_back(toMsg(process));
+    }
+    for (const auto& thread : s_top_scanner->topThreads) {
+      msg::TopThread info;
+      info.pid = thread.pid;
+      info.id = thread.tid;
+      info.name = thread.name;
+      info.usage = thread.usage;
+      msg.threads.push_back(std::move(info));
+    }
+    msg.process_num = s_top_scanner->processes;
+    msg.thread_num = s_top_scanner->threads;
+    msg.timestamps = timestampsNow;
+    snapshot.top = std::make_unique<msg::TopMsg>(std::move(msg));
   }
 
   // process info
-  {
+  if (streams & STREAM_PROCESS) {
     msg::ProcessMsg msg;
-    for (const auto& monitorPid : s_monitor_pids) {
+    for (auto& monitorPid : s_monitor_pids) {
       auto& id = monitorPid.first;
       auto& tasks = monitorPid.second.tasks;
       auto& memUsage = monitorPid.second.memUsage;
@@ -224,112 +613,442 @@ static void sendNowInfos() {
         mem.size = memUsage.VmSize;
         mem.hwm = memUsage.VmHWM;
         mem.rss = memUsage.VmRSS;
+        auto& rollup = monitorPid.second.memRollup;
+        mem.pss = rollup.Pss;
+        mem.uss = rollup.Uss;
+        mem.rss_anon = rollup.RssAnon;
+        mem.rss_file = rollup.RssFile;
+        mem.rss_shmem = rollup.RssShmem;
+        mem.swap = rollup.Swap;
         mem.timestamps = timestampsNow;
         processInfo.mem_info = mem;
       }
 
-      for (const auto& task : tasks) {
+      processInfo.io_info = monitorPid.second.io;
+      processInfo.io_info.timestamps = timestampsNow;
+
+      auto intervalNs = monitorPid.second.intervalNs;
+      float perSecond = intervalNs ? 1e9f / (float)intervalNs : 0;
+#ifdef __APPLE__
+      // thread_basic_info has no context switches
+      bool hasCtxSwitches = false;
+#else
+      bool hasCtxSwitches = true;
+#endif
+      tasks.forEach([&](const TaskTable::Row& task) {
         msg::ThreadInfo taskInfo;
-        taskInfo.id = task->id;
-        taskInfo.name = task->name;
-        taskInfo.usage = task->usage;
+        taskInfo.id = task.id;
+        taskInfo.name = task.name;
+        taskInfo.usage = task.usage;
+        taskInfo.latency = task.cpuDelayNs / 1e6f;
+        taskInfo.min_flt = task.minFlt * perSecond;
+        taskInfo.maj_flt = task.majFlt * perSecond;
+        taskInfo.ctx_switches = hasCtxSwitches ? task.ctxSwitches * perSecond : -1;
+        taskInfo.invol_ctx_switches = hasCtxSwitches ? task.involCtxSwitches * perSecond : -1;
         taskInfo.timestamps = timestampsNow;
         processInfo.thread_infos.push_back(std::move(taskInfo));
-      }
+      });
+      processInfo.thread_events = std::move(monitorPid.second.threadEvents);
+      monitorPid.second.threadEvents.clear();
       msg.infos.push_back(std::move(processInfo));
     }
     msg.timestamps = timestampsNow;
-    s_rpc->cmd("on_process_msg")->msg(msg)->call();
+    snapshot.process = std::make_unique<msg::ProcessMsg>(std::move(msg));
+  }
+
+  // cgroup info
+  if (streams & STREAM_CGROUP) {
+    msg::CgroupMsg msg;
+    for (const auto& item : s_monitor_cgroups) {
+      msg::CgroupInfo info = item.second.info;
+      info.timestamps = timestampsNow;
+      msg.infos.push_back(std::move(info));
+    }
+    msg.timestamps = timestampsNow;
+    snapshot.cgroup = std::make_unique<msg::CgroupMsg>(std::move(msg));
+  }
+
+  // pressure info
+  if (s_argv.e_pressure && (streams & STREAM_PRESSURE)) {
+    msg::PressureMsg msg;
+    auto add = [&](const PressureValue& value) {
+      msg::PressureInfo info = value.info;
+      info.timestamps = timestampsNow;
+      msg.infos.push_back(std::move(info));
+    };
+    for (const auto& value : s_monitor_pressure) {
+      add(value);
+    }
+    for (const auto& item : s_monitor_cgroups) {
+      for (const auto& value : item.second.pressure) {
+        add(value);
+      }
+    }
+    msg.timestamps = timestampsNow;
+    snapshot.pressure = std::make_unique<msg::PressureMsg>(std::move(msg));
+  }
+}
+
+static bool containsId(const std::vector<uint64_t>& sortedIds, uint64_t id) {
+  return sortedIds.empty() || std::binary_search(sortedIds.cbegin(), sortedIds.cend(), id);
+}
+
+/**
+ * thread events of an update skipped by `every`, sent with the next msg
+ */
+static void keepThreadEvents(Session& session, const msg::ProcessMsg& msg) {
+  const auto& sub = session.subscription;
+  if (!sub.threads) return;
+  for (const auto& info : msg.infos) {
+    if (!containsId(sub.pids, info.id)) continue;
+    for (const auto& event : info.thread_events) {
+      if (!containsId(sub.tids, event.id)) continue;
+      auto& kept = session.threadEvents[info.id];
+      kept.id = info.id;
+      kept.name = info.name;
+      kept.thread_events.push_back(event);
+    }
+  }
+}
+
+/**
+ * @return `msg` itself if the session takes all of it, or `filtered`
+ */
+static const msg::ProcessMsg& filterProcessMsg(Session& session, const msg::ProcessMsg& msg, msg::ProcessMsg& filtered) {
+  const auto& sub = session.subscription;
+  if (sub.pids.empty() && sub.tids.empty() && sub.threads && session.threadEvents.empty()) return msg;
+
+  filtered.timestamps = msg.timestamps;
+  for (const auto& info : msg.infos) {
+    if (!containsId(sub.pids, info.id)) continue;
+    msg::ProcessInfo processInfo;
+    processInfo.id = info.id;
+    processInfo.name = info.name;
+    processInfo.mem_info = info.mem_info;
+    processInfo.io_info = info.io_info;
+    if (sub.threads) {
+      for (const auto& thread : info.thread_infos) {
+        if (containsId(sub.tids, thread.id)) processInfo.thread_infos.push_back(thread);
+      }
+      auto iter = session.threadEvents.find(info.id);
+      if (iter != session.threadEvents.cend()) {
+        processInfo.thread_events = std::move(iter->second.thread_events);
+        session.threadEvents.erase(iter);
+      }
+      for (const auto& event : info.thread_events) {
+        if (containsId(sub.tids, event.id)) processInfo.thread_events.push_back(event);
+      }
+    }
+    filtered.infos.push_back(std::move(processInfo));
+  }
+  // the process exited or was removed meanwhile, its last events are still sent
+  for (auto& item : session.threadEvents) {
+    filtered.gone_infos.push_back(std::move(item.second));
+  }
+  session.threadEvents.clear();
+  return filtered;
+}
+
+/**
+ * only the streams the session subscribes to are serialized
+ */
+static void sendSnapshot(Session& session, const Snapshot& snapshot) {
+  auto& rpc = session.rpc;
+  auto streams = session.streams;
+  // sent as they come, not decimated by `every`
+  if (snapshot.pressureEvent && (streams & STREAM_PRESSURE_EVENT)) rpc->cmd("on_pressure_event")->msg(*snapshot.pressureEvent)->call();
+  if (!snapshot.tick) return;
+
+  if (session.updates++ % session.subscription.every != 0) {
+    if (snapshot.process && (streams & STREAM_PROCESS)) keepThreadEvents(session, *snapshot.process);
+    return;
+  }
+
+  if (streams & STREAM_PLUGIN_MALLOC) {
+    for (const auto& msg : snapshot.mallocs) {
+      rpc->cmd("/plugin/malloc")->msg(msg)->call();
+    }
+  }
+  if (snapshot.memInfo && (streams & STREAM_PLUGIN_MEMINFO)) rpc->cmd("/plugin/meminfo")->msg(*snapshot.memInfo)->call();
+  if (snapshot.cpu && (streams & STREAM_CPU)) {
+    if (session.binaryEncoding) {
+      rpc->cmd("on_cpu_bin")->msg(session.binaryEncoder.encode(*snapshot.cpu))->call();
+    } else {
+      rpc->cmd("on_cpu_msg")->msg(*snapshot.cpu)->call();
+    }
+  }
+  if (snapshot.top && (streams & STREAM_TOP)) rpc->cmd("on_top_msg")->msg(*snapshot.top)->call();
+  if (snapshot.process && (streams & STREAM_PROCESS)) {
+    msg::ProcessMsg filtered;
+    const auto& msg = filterProcessMsg(session, *snapshot.process, filtered);
+    if (session.binaryEncoding) {
+      rpc->cmd("on_process_bin")->msg(session.binaryEncoder.encode(msg))->call();
+    } else {
+      rpc->cmd("on_process_msg")->msg(msg)->call();
+    }
+  }
+  if (snapshot.cgroup && (streams & STREAM_CGROUP)) rpc->cmd("on_cgroup_msg")->msg(*snapshot.cgroup)->call();
+  if (snapshot.pressure && (streams & STREAM_PRESSURE)) rpc->cmd("on_pressure_msg")->msg(*snapshot.pressure)->call();
+  if (streams & STREAM_TICK) rpc->cmd("on_tick_msg")->msg(*snapshot.tick)->call();
+}
+
+/**
+ * on the network thread
+ */
+static void sendSnapshots() {
+  // cleared first, a snapshot pushed while draining posts again
+  s_snapshots_posted = false;
+  std::unique_ptr<Snapshot> snapshot;
+  while (s_snapshots.pop(snapshot)) {
+    for (const auto& session : s_sessions) {
+      sendSnapshot(*session, *snapshot);
+    }
+  }
+}
+
+/**
+ * on the sampling thread, never waits for the network thread
+ */
+static void pushSnapshot(std::unique_ptr<Snapshot> snapshot) {
+  if (!s_snapshots.push(std::move(snapshot))) {
+    ++s_snapshots_dropped;
+    LOGW("network thread falls behind, snapshot dropped: %" PRIu64, s_snapshots_dropped);
+    return;
+  }
+  if (!s_snapshots_posted.exchange(true)) {
+    asio::post(*s_net_context, sendSnapshots);
   }
 }
 
 static void runServer() {
-  initRpcTask();
   using namespace asio_net;
-  rpc_config rpc_config;
-  rpc_config.rpc = s_rpc;
+  rpc_config rpc_config;  // without rpc, each session has its own
   rpc_config.max_body_size = MessageMaxByteSize;
-  s_rpc_server = std::make_unique<rpc_server>(*s_context, s_argv.s_server_port, std::move(rpc_config));
+  s_net_context = std::make_unique<asio::io_context>();
+  s_rpc_server = std::make_unique<rpc_server>(*s_net_context, s_argv.s_server_port, std::move(rpc_config));
   s_rpc_server->on_session = [](const std::weak_ptr<rpc_session>& ws) {
-    LOGI("device connected");
-    ws.lock()->on_close = [] {
-      LOGI("device disconnected");
+    auto rpcSession = ws.lock();
+    auto session = std::make_shared<Session>();
+    session->rpc = rpcSession->rpc;
+    initRpcTask(session);
+    s_sessions.push_back(session);
+    updateStreamsWanted();
+    LOGI("device connected, sessions: %zu", s_sessions.size());
+    rpcSession->on_close = [session] {
+      s_sessions.remove(session);
+      updateStreamsWanted();
+      LOGI("device disconnected, sessions: %zu", s_sessions.size());
     };
   };
   LOGI("start server: port: %d", s_argv.s_server_port);
+  s_sample_thread = std::thread(runApp);
   s_rpc_server->start(true);
+  s_context->stop();
+  s_sample_thread.join();
 }
 
 static void updateCpu() {
   s_monitor_cpu->update(true);
-  printf("system %s usage: %.2f%%\n", s_monitor_cpu->ave->name.c_str(), s_monitor_cpu->ave->usage);
+  print("system %s usage: %.2f%%\n", s_monitor_cpu->ave->name.c_str(), s_monitor_cpu->ave->usage);
 }
 
-static void updateProcess() {
-  for (auto& item : s_monitor_pids) {
-    auto& tasks = item.second.tasks;
-    auto& memUsage = item.second.memUsage;
-    auto memUsageRet = MemMonitor::getUsage(item.first.pid);
-    if (!memUsageRet.ok) {
-      printf("process exit: name: %-15s, id: %-7" PRIu32 "\n", item.first.name.c_str(), item.first.pid);
-      continue;
-    }
+static void updateTop() {
+  if (!s_top_scanner) return;
+  if (!s_top_scanner->scan()) {
+    LOGE("scan processes failed: %s", strerror(errno));
+    return;
+  }
+  print("top: processes: %zu, threads: %zu\n", s_top_scanner->processes, s_top_scanner->threads);
+  for (const auto& process : s_top_scanner->topCpu) {
+    print("top cpu: name: %-15s, id: %-7" PRIu32 ", usage: %.2f%%, threads: %u\n", process.name.c_str(), process.pid, process.usage,
+          process.threads);
+  }
+  for (const auto& thread : s_top_scanner->topThreads) {
+    print("top thread: name: %-15s, id: %-7" PRIu32 ", pid: %-7" PRIu32 ", usage: %.2f%%\n", thread.name.c_str(), thread.tid, thread.pid,
+          thread.usage);
+  }
+  for (const auto& process : s_top_scanner->topRss) {
+    print("top rss: name: %-15s, id: %-7" PRIu32 ", rss: %" PRIu64 " kB\n", process.name.c_str(), process.pid, process.rss);
+  }
+  print("\n");
+}
 
-    memUsage = memUsageRet.usage;
-    printf("VmPeak: %8zu kB\n", memUsage.VmPeak);
-    printf("VmSize: %8zu kB\n", memUsage.VmSize);
-    printf("VmHWM:  %8zu kB\n", memUsage.VmHWM);
-    printf("VmRSS:  %8zu kB\n", memUsage.VmRSS);
-    for (auto& task : tasks) {
-      bool ok = task->update();
-      if (ok) {
-        printf("name: %-15s, id: %-7" PRIu32 ", usage: %.2f%%\n", task->name.c_str(), task->id, task->usage);
-      } else {
-        printf("thread exit: name: %s, id: %" PRIu32 "\n", task->name.c_str(), task->id);
+static void addThreadEvent(ProcessValue& process, TaskId_t tid, const std::string& name, bool exit, uint64_t timestamps) {
+  print("thread %s: name: %s, id: %" PRIu32 "\n", exit ? "exit" : "birth", name.c_str(), tid);
+  if (!(s_streams_wanted & STREAM_PROCESS)) return;
+  msg::ThreadEvent event;
+  event.id = tid;
+  event.name = name;
+  event.exit = exit;
+  event.timestamps = timestamps;
+  process.threadEvents.push_back(std::move(event));
+}
+
+static void handleProcEvents() {
+  static std::vector<ProcEvent> events;
+  events.clear();
+  if (!s_proc_events->read(events)) {
+    LOGW("proc events lost, resync threads by polling");
+    s_proc_events_resync = true;
+    // lost execs are not found by listing the pids, names of all processes are read again
+    if (s_process_index) s_process_index->invalidate();
+  }
+
+  auto nowNs = steadyNowNs();
+  auto timestampsNow = utils::getTimestamps();
+  for (const auto& event : events) {
+    if (s_process_index) s_process_index->onEvent(event);
+    if (event.type == ProcEvent::Type::EXEC) continue;
+    auto iter = s_monitor_pids.find(ProcessKey{event.pid, {}});
+    if (iter == s_monitor_pids.cend()) continue;
+    auto& process = iter->second;
+    auto timestamps = timestampsNow - (nowNs - event.timestampNs) / 1000000;
+
+    auto row = process.tasks.find(event.tid);
+    if (event.type == ProcEvent::Type::FORK) {
+      // already listed by the last sample
+      if (row != TaskTable::NotFound) continue;
+
+      // the thread may have exited already, it has the name of its creator then
+      TaskSample sample{};
+      sample.id = event.tid;
+      char commPath[64];
+      snprintf(commPath, sizeof(commPath), "/proc/%d/task/%u/comm", event.pid, event.tid);
+      bool ok;
+      auto name = file_utils::read_text_file(commPath, &ok);
+      if (!ok) {
+        name = iter->first.name;
+      } else if (!name.empty() && name.back() == '\n') {
+        name.pop_back();
       }
+      snprintf(sample.name, sizeof(sample.name), "%s", name.c_str());
+      // cpu time is counted from 0 at birth
+      process.tasks.insert(sample);
+      addThreadEvent(process, event.tid, name, false, timestamps);
+    } else {
+      if (row == TaskTable::NotFound) continue;
+      addThreadEvent(process, event.tid, process.tasks.row(row).name, true, timestamps);
+      process.tasks.erase(event.tid);
     }
-    printf("\n");
   }
 }
 
-static void updateProcessChange() {
-  std::vector<ProcessKey> alreadyExit;
-  for (auto& monitorPid : s_monitor_pids) {
-    auto& process = monitorPid.first;
-    auto pid = process.pid;
-    auto& tasks = monitorPid.second.tasks;
+static void asyncWaitProcEvents() {
+  s_proc_events_stream->async_wait(asio::posix::stream_descriptor::wait_read, [](asio::error_code ec) {
+    if (ec) return;
+    handleProcEvents();
+    asyncWaitProcEvents();
+  });
+}
+
+static void updateMem(ProcessValue& process, const MemMonitor::Statm& statm, uint64_t timestampNs) {
+  auto& usage = process.memUsage;
+  usage.VmSize = statm.VmSize;
+  usage.VmRSS = statm.VmRSS;
+
+  auto intervalNs = (uint64_t)s_argv.m_mem_rollup_interval_ms * 1000000;
+  if (intervalNs && timestampNs - process.memRollupTryNs >= intervalNs) {
+    process.memRollupTryNs = timestampNs;
+    // e.g. EACCES for a process of another user, the last values are kept and it is tried again next interval
+    if (process.mem->sampleRollup(&process.memRollup)) {
+      process.memRollupTimestampNs = timestampNs;
+      process.memRollupFailed = false;
+    } else if (!process.memRollupFailed) {
+      LOGW("smaps_rollup of pid %d not available: %s", process.mem->pid, strerror(errno));
+      process.memRollupFailed = true;
+    }
+    // VmPeak and VmHWM are only in status, refresh them along
+    auto ret = MemMonitor::getUsage(process.mem->pid);
+    if (ret.ok) usage = ret.usage;
+  }
+
+  // statm has no peak, keep them at least the current values between the reads of status
+  usage.VmPeak = std::max(usage.VmPeak, usage.VmSize);
+  usage.VmHWM = std::max(usage.VmHWM, usage.VmRSS);
+}
 
-    const auto& taskRet = Utils::getTasksOfPid(pid);
-    if (!taskRet.ok) {
+static void updateProcess() {
+  // threads are listed by the kernel events, only the ones already known are sampled
+  if (s_proc_events) handleProcEvents();
+  bool listTasks = !s_proc_events || s_proc_events_resync;
+  s_proc_events_resync = false;
+
+  std::vector<ProcessKey> alreadyExit;
+  for (auto& item : s_monitor_pids) {
+    auto& process = item.first;
+    auto& sampler = *item.second.sampler;
+    auto& tasks = item.second.tasks;
+    auto& tids = item.second.tids;
+    auto& memUsage = item.second.memUsage;
+    MemMonitor::Statm statm;  // NOLINT
+    bool memOk = item.second.mem->sampleStatm(&statm);
+    auto lastTimestampNs = sampler.timestampNs;
+    auto lastIo = sampler.io;
+    bool lastIoOk = sampler.ioOk;
+    if (!listTasks) {
+      tids.clear();
+      tasks.forEach([&](const TaskTable::Row& task) {
+        tids.push_back(task.id);
+      });
+    }
+    if (!memOk || !(listTasks ? sampler.sample() : sampler.sample(tids))) {
+      print("process exit: name: %-15s, id: %-7" PRIu32 "\n", process.name.c_str(), process.pid);
       alreadyExit.push_back(process);
       continue;
     }
-    const auto& tasksNow = taskRet.ids;
+    auto intervalNs = sampler.timestampNs - lastTimestampNs;
+    item.second.intervalNs = intervalNs;
+    float perSecond = intervalNs ? 1e9f / (float)intervalNs : 0;
 
-    // 删除已不存在的线程
-    const auto isTaskAlive = [&](TaskId_t taskId) {
-      return std::find(tasksNow.cbegin(), tasksNow.cend(), taskId) != tasksNow.cend();
-    };
-    for (auto iter = tasks.begin(); iter != tasks.cend();) {
-      // delete not cared task
-      if (!isTaskAlive(iter->get()->id)) {
-        iter = tasks.erase(iter);
-      } else {
-        ++iter;
-      }
+    auto& io = item.second.io;
+    io = {};
+    if (lastIoOk && sampler.ioOk) {
+      auto& cur = sampler.io;
+      io.rchar = (cur.rchar - lastIo.rchar) * perSecond;
+      io.wchar = (cur.wchar - lastIo.wchar) * perSecond;
+      io.read_bytes = (cur.readBytes - lastIo.readBytes) * perSecond;
+      io.write_bytes = (cur.writeBytes - lastIo.writeBytes) * perSecond;
+      print("io rchar/wchar: %.1f/%.1f kB/s, read/write bytes: %.1f/%.1f kB/s\n", io.rchar / 1024, io.wchar / 1024, io.read_bytes / 1024,
+            io.write_bytes / 1024);
     }
 
-    // 添加新增的线程
-    const auto isNewTask = [&](TaskId_t taskId) {
-      return std::find_if(tasks.cbegin(), tasks.cend(), [taskId](const std::unique_ptr<TaskMonitor>& monitor) {
-               return monitor->id == taskId;
-             }) == tasks.cend();
-    };
-    for (const auto& tid : tasksNow) {
-      if (isNewTask(tid)) {
-        tasks.push_back(std::make_unique<TaskMonitor>(tid, s_total_time_impl));
-      }
+    updateMem(item.second, statm, sampler.timestampNs);
+    print("VmPeak: %8zu kB\n", memUsage.VmPeak);
+    print("VmSize: %8zu kB\n", memUsage.VmSize);
+    print("VmHWM:  %8zu kB\n", memUsage.VmHWM);
+    print("VmRSS:  %8zu kB\n", memUsage.VmRSS);
+    if (item.second.memRollupTimestampNs) {
+      auto& rollup = item.second.memRollup;
+      print("Pss: %zu kB, Uss: %zu kB, RssAnon: %zu kB, RssFile: %zu kB, RssShmem: %zu kB, Swap: %zu kB\n", rollup.Pss, rollup.Uss,
+            rollup.RssAnon, rollup.RssFile, rollup.RssShmem, rollup.Swap);
     }
+
+    // 更新已有线程 添加新增的线程 删除已不存在的线程
+    // births reported by proc events are in `tasks` already
+    auto timestampsNow = utils::getTimestamps();
+    tasks.update(
+        sampler.samples, intervalNs,
+        [&](const TaskSample& sample) {
+          addThreadEvent(item.second, sample.id, sample.name, false, timestampsNow);
+        },
+        [&](const TaskTable::Row& task) {
+          addThreadEvent(item.second, task.id, task.name, true, timestampsNow);
+        });
+    tasks.forEach([&](const TaskTable::Row& task) {
+      if (sampler.backend == ProcessTaskSampler::Backend::SCHEDSTAT) {
+        print("name: %-15s, id: %-7" PRIu32 ", usage: %.2f%%, run queue latency: %.3f ms, cs/invol: %.0f/%.0f/s\n", task.name.c_str(), task.id,
+              task.usage, task.cpuDelayNs / 1e6, task.ctxSwitches * perSecond, task.involCtxSwitches * perSecond);
+      } else if (sampler.backend == ProcessTaskSampler::Backend::TASKSTATS) {
+        print("name: %-15s, id: %-7" PRIu32 ", usage: %.2f%%, delay cpu/blkio/swapin: %.3f/%.3f/%.3f ms, flt min/maj: %.0f/%.0f/s, cs/invol: %.0f/%.0f/s\n",
+              task.name.c_str(), task.id, task.usage, task.cpuDelayNs / 1e6, task.blkioDelayNs / 1e6, task.swapinDelayNs / 1e6,
+              task.minFlt * perSecond, task.majFlt * perSecond, task.ctxSwitches * perSecond, task.involCtxSwitches * perSecond);
+      } else {
+        print("name: %-15s, id: %-7" PRIu32 ", usage: %.2f%%, flt min/maj: %.0f/%.0f/s, cs/invol: %.0f/%.0f/s\n", task.name.c_str(), task.id,
+              task.usage, task.minFlt * perSecond, task.majFlt * perSecond, task.ctxSwitches * perSecond, task.involCtxSwitches * perSecond);
+      }
+    });
+
+    print("\n");
   }
 
   for (const auto& key : alreadyExit) {
@@ -338,21 +1057,32 @@ static void updateProcessChange() {
 }
 
 static bool addMonitorPid(PID_t pid) {
-  auto ret = Utils::getTasksOfPid(pid);
-  LOGI("get task info: pid: %u, ok: %d, num: %zu", pid, ret.ok, ret.ids.size());
-  if (!ret.ok) {
+  auto backend = ProcessTaskSampler::Backend::PROCFS;
+  if (s_argv.t_use_taskstats) {
+    backend = ProcessTaskSampler::Backend::TASKSTATS;
+  } else if (s_argv.r_use_schedstat) {
+    backend = ProcessTaskSampler::Backend::SCHEDSTAT;
+  }
+  auto sampler = std::make_unique<ProcessTaskSampler>(pid, backend);
+  bool ok = sampler->sample();
+  LOGI("get task info: pid: %u, ok: %d, num: %zu", pid, ok, sampler->samples.size());
+  if (!ok) {
     LOGE("pid not found: %u", pid);
     return false;
   }
 
   // add to monitor
-  auto& monitorTask = s_monitor_pids[{pid, ret.name}];
+  auto& monitorTask = s_monitor_pids[{pid, sampler->name}];
+  monitorTask.mem = std::make_unique<MemMonitor>(pid);
+  auto memUsageRet = MemMonitor::getUsage(pid);
+  if (memUsageRet.ok) monitorTask.memUsage = memUsageRet.usage;
 
   // add threads
-  for (auto tid : ret.ids) {
-    LOGI("thread id: %d", tid);
-    monitorTask.tasks.push_back(std::make_unique<TaskMonitor>(tid, s_total_time_impl));
+  for (const auto& sample : sampler->samples) {
+    LOGI("thread id: %d", sample.id);
   }
+  monitorTask.tasks.update(sampler->samples, 0);
+  monitorTask.sampler = std::move(sampler);
 
   return true;
 }
@@ -365,31 +1095,369 @@ static bool addMonitorPid(const std::string& pid) {
   return addMonitorPid(pid_t);
 }
 
+static void matchWatches(const std::vector<PID_t>& updated);
+
+static bool updateProcessIndex() {
+  if (!s_process_index) s_process_index = std::make_unique<ProcessIndex>();
+  // births and execs not handled yet
+  if (s_proc_events) {
+    handleProcEvents();
+  } else {
+    auto nowNs = steadyNowNs();
+    if (nowNs - s_process_index_refresh_ns >= ProcessIndexRefreshNs) {
+      s_process_index_refresh_ns = nowNs;
+      s_process_index->invalidate();
+    }
+  }
+  // /proc is listed once more after proc events are opened, then only the new and exec'd processes are read
+  if (!s_process_index->update(s_process_index_list)) {
+    LOGE("list processes failed");
+    return false;
+  }
+  s_process_index_list = !s_proc_events;
+  // the new and exec'd processes are only in updated() until the next update, e.g. by add_name
+  matchWatches(s_process_index->updated());
+  return true;
+}
+
+static std::vector<PID_t> findPidsByName(const std::string& name) {
+  if (!updateProcessIndex()) return {};
+  return s_process_index->find(ProcessIndex::Query::parse(name));
+}
+
+static void attachWatch(const std::string& name, const std::vector<PID_t>& pids) {
+  for (auto pid : pids) {
+    // a cmdline pattern may match the daemon started with it
+    if (pid == getpid() || s_monitor_pids.count(ProcessKey{pid, {}})) continue;
+    LOGI("watch %s: attach pid: %d", name.c_str(), pid);
+    if (!addMonitorPid(pid)) continue;
+    s_monitor_pids.find(ProcessKey{pid, {}})->second.watch = name;
+  }
+}
+
+/**
+ * @return false if the pattern is not a valid regex
+ */
+static bool addWatch(const msg::WatchRule& rule) {
+  ProcessIndex::Matcher matcher(ProcessIndex::Query::parse(rule.name));
+  if (!matcher.valid()) return false;
+  s_watch_rules.emplace(rule.name, WatchRule{std::move(matcher), rule.children});
+
+  auto pids = findPidsByName(rule.name);
+  if (rule.children) {
+    auto descendants = s_process_index->descendants(pids);
+    pids.insert(pids.end(), descendants.cbegin(), descendants.cend());
+  }
+  attachWatch(rule.name, pids);
+  return true;
+}
+
+static bool delWatch(const std::string& name) {
+  if (!s_watch_rules.erase(name)) return false;
+  for (auto iter = s_monitor_pids.begin(); iter != s_monitor_pids.end();) {
+    if (iter->second.watch == name) {
+      iter = s_monitor_pids.erase(iter);
+    } else {
+      ++iter;
+    }
+  }
+  return true;
+}
+
+/**
+ * attach the processes born or exec'd since the last update, only they are matched against the rules
+ */
+static void matchWatches(const std::vector<PID_t>& updated) {
+  if (s_watch_rules.empty() || updated.empty()) return;
+
+  for (const auto& item : s_watch_rules) {
+    auto& name = item.first;
+    auto& watch = item.second;
+    attachWatch(name, s_process_index->find(watch.matcher, updated));
+    if (!watch.children) continue;
+
+    // a parent attached by this rule, born in the same interval or earlier
+    // the depth is limited as the parents of exited processes may be reused pids
+    std::vector<PID_t> children;
+    for (auto pid : updated) {
+      auto parent = s_process_index->parent(pid);
+      for (int depth = 0; parent > 1 && depth < 64; ++depth, parent = s_process_index->parent(parent)) {
+        auto iter = s_monitor_pids.find(ProcessKey{parent, {}});
+        if (iter != s_monitor_pids.cend() && iter->second.watch == name) {
+          children.push_back(pid);
+          break;
+        }
+      }
+    }
+    attachWatch(name, children);
+  }
+}
+
+static void updateWatches() {
+  if (!s_watch_rules.empty()) updateProcessIndex();
+}
+
 static bool addMonitorPidByName(const std::string& name) {
-  auto pid = Utils::getPidByName(name);
-  return addMonitorPid(pid);
-}
-
-static void asyncNextUpdate() {
-  s_timer_update->expires_after(std::chrono::milliseconds(s_argv.d_update_interval_ms));
-  s_timer_update->async_wait([](asio::error_code ec) {
-    updateCpu();
-    updateProcess();
-    sendPluginsInfos();
-    sendNowInfos();
-    updateProcessChange();
-    asyncNextUpdate();
+  auto pids = findPidsByName(name);
+  LOGI("find name: %s, num: %zu", name.c_str(), pids.size());
+  if (pids.empty()) {
+    LOGE("name not found: %s", name.c_str());
+    return false;
+  }
+  bool ok = false;
+  for (auto pid : pids) {
+    if (s_monitor_pids.count(ProcessKey{pid, {}})) continue;
+    ok |= addMonitorPid(pid);
+  }
+  return ok;
+}
+
+// counters are totals, a recreated cgroup of the same path starts over from 0
+static uint64_t delta(uint64_t cur, uint64_t last) {
+  return cur > last ? cur - last : 0;
+}
+
+static void addPressureMonitors(std::vector<PressureValue>& values, const std::string& cgroup) {
+  for (auto resource : {PressureMonitor::Resource::CPU, PressureMonitor::Resource::MEMORY, PressureMonitor::Resource::IO}) {
+    PressureValue value;
+    value.monitor = std::make_unique<PressureMonitor>(resource, cgroup);
+    if (!value.monitor->sample(&value.sample)) continue;
+    value.info.resource = PressureMonitor::name(resource);
+    value.info.cgroup = cgroup;
+    values.push_back(std::move(value));
+  }
+}
+
+static bool samplePressure(PressureValue& value) {
+  auto last = value.sample;
+  if (!value.monitor->sample(&value.sample)) return false;
+  auto& cur = value.sample;
+  auto& info = value.info;
+  info.some_avg10 = cur.some.avg10;
+  info.some_avg60 = cur.some.avg60;
+  info.some_avg300 = cur.some.avg300;
+  info.full_avg10 = cur.full.avg10;
+  info.full_avg60 = cur.full.avg60;
+  info.full_avg300 = cur.full.avg300;
+  info.some_ms = delta(cur.some.totalUsec, last.some.totalUsec) / 1e3f;
+  info.full_ms = delta(cur.full.totalUsec, last.full.totalUsec) / 1e3f;
+  return true;
+}
+
+static void printPressure(const char* prefix, const msg::PressureInfo& info) {
+  print("%s%s%s%s, some avg10/60/300: %.2f/%.2f/%.2f%% %.3f ms, full avg10/60/300: %.2f/%.2f/%.2f%% %.3f ms\n", prefix, info.resource.c_str(),
+        info.cgroup.empty() ? "" : " of cgroup ", info.cgroup.c_str(), info.some_avg10, info.some_avg60, info.some_avg300, info.some_ms,
+        info.full_avg10, info.full_avg60, info.full_avg300, info.full_ms);
+}
+
+static void updatePressure() {
+  if (!s_argv.e_pressure) return;
+  for (auto& value : s_monitor_pressure) {
+    if (samplePressure(value)) printPressure("pressure: ", value.info);
+  }
+  for (auto& item : s_monitor_cgroups) {
+    for (auto& value : item.second.pressure) {
+      if (samplePressure(value)) printPressure("pressure: ", value.info);
+    }
+  }
+}
+
+static std::string pressureRuleKey(const msg::PressureRule& rule) {
+  auto key = rule.resource + (rule.full ? ":full:" : ":some:") + std::to_string(rule.stall_ms) + ":" + std::to_string(rule.window_ms);
+  if (!rule.cgroup.empty()) key += ":" + rule.cgroup;
+  return key;
+}
+
+/**
+ * parse `resource:some|full:stall_ms:window_ms[:cgroup]`, like `cpu:some:100:2000`
+ */
+static bool parsePressureRule(const std::string& spec, msg::PressureRule* rule) {
+  auto fields = string_utils::Split(spec, ":");
+  if (fields.size() < 4 || (fields[1] != "some" && fields[1] != "full")) return false;
+  char* end;
+  rule->resource = fields[0];
+  rule->full = fields[1] == "full";
+  rule->stall_ms = strtoul(fields[2].c_str(), &end, 10);
+  if (fields[2].empty() || *end != '\0') return false;
+  rule->window_ms = strtoul(fields[3].c_str(), &end, 10);
+  if (fields[3].empty() || *end != '\0') return false;
+  // the rest is the path, which may contain `:`
+  rule->cgroup.clear();
+  if (fields.size() > 4) {
+    size_t pos = 0;
+    for (int i = 0; i < 4; ++i) pos = spec.find(':', pos) + 1;
+    rule->cgroup = spec.substr(pos);
+  }
+  return true;
+}
+
+static void asyncWaitPressureTrigger(const std::string& key) {
+  auto& value = s_pressure_triggers.at(key);
+  // the kernel reports a stall by POLLPRI, which is the error condition of asio
+  value.stream->async_wait(asio::posix::stream_descriptor::wait_error, [key](asio::error_code ec) {
+    if (ec) return;
+    auto iter = s_pressure_triggers.find(key);
+    if (iter == s_pressure_triggers.cend()) return;
+    auto& value = iter->second;
+    if (!value.trigger->alive()) {
+      LOGW("pressure trigger removed: %s", key.c_str());
+      s_pressure_triggers.erase(iter);
+      return;
+    }
+
+    auto timestampsNow = utils::getTimestamps();
+    samplePressure(value.pressure);
+    printPressure("pressure stall over threshold: ", value.pressure.info);
+    if (s_streams_wanted & STREAM_PRESSURE_EVENT) {
+      auto snapshot = std::make_unique<Snapshot>();
+      snapshot->pressureEvent = std::make_unique<msg::PressureEvent>();
+      auto& event = *snapshot->pressureEvent;
+      event.rule = value.rule;
+      event.info = value.pressure.info;
+      event.info.timestamps = timestampsNow;
+      event.timestamps = timestampsNow;
+      pushSnapshot(std::move(snapshot));
+    }
+    asyncWaitPressureTrigger(key);
   });
 }
 
+static bool addPressureTrigger(const msg::PressureRule& rule) {
+  auto key = pressureRuleKey(rule);
+  PressureMonitor::Resource resource;
+  if (!PressureMonitor::parse(rule.resource, &resource)) {
+    LOGE("unknown pressure resource: %s", rule.resource.c_str());
+    errno = EINVAL;
+    return false;
+  }
+  auto trigger = std::make_unique<PressureTrigger>();
+  if (!trigger->open(resource, rule.cgroup, rule.full, rule.stall_ms * 1000, rule.window_ms * 1000)) {
+    int err = errno;
+    LOGE("add pressure trigger failed: %s: %s", key.c_str(), strerror(err));
+    errno = err;
+    return false;
+  }
+
+  auto& value = s_pressure_triggers[key];
+  value.rule = rule;
+  value.pressure.monitor = std::make_unique<PressureMonitor>(resource, rule.cgroup);
+  value.pressure.monitor->sample(&value.pressure.sample);
+  value.pressure.info.resource = rule.resource;
+  value.pressure.info.cgroup = rule.cgroup;
+  // the descriptor is closed by asio, keep PressureTrigger its own
+  value.stream = std::make_unique<asio::posix::stream_descriptor>(*s_context, dup(trigger->fd()));
+  value.trigger = std::move(trigger);
+  asyncWaitPressureTrigger(key);
+  return true;
+}
+
+static void updateCgroups() {
+  for (auto iter = s_monitor_cgroups.begin(); iter != s_monitor_cgroups.end();) {
+    auto& path = iter->first;
+    auto& value = iter->second;
+    auto last = value.sample;
+    auto lastTimestampNs = value.timestampNs;
+    if (!value.monitor->sample(&value.sample)) {
+      print("cgroup removed: %s\n", path.c_str());
+      iter = s_monitor_cgroups.erase(iter);
+      continue;
+    }
+    value.timestampNs = steadyNowNs();
+
+    auto& cur = value.sample;
+    auto& info = value.info;
+    auto intervalUsec = (value.timestampNs - lastTimestampNs) / 1000;
+    float percent = intervalUsec ? 100.0f / (float)intervalUsec : 0;
+    info.path = path;
+    info.usage = delta(cur.usageUsec, last.usageUsec) * percent;
+    info.user = delta(cur.userUsec, last.userUsec) * percent;
+    info.system = delta(cur.systemUsec, last.systemUsec) * percent;
+    info.quota = cur.periodUsec ? (float)cur.quotaUsec / (float)cur.periodUsec : 0;
+    info.nr_periods = delta(cur.nrPeriods, last.nrPeriods);
+    info.nr_throttled = delta(cur.nrThrottled, last.nrThrottled);
+    info.throttled_ms = delta(cur.throttledUsec, last.throttledUsec) / 1e3f;
+    info.mem_current = cur.memCurrent / 1024;
+    info.mem_max = cur.memMax / 1024;
+    info.anon = cur.anon / 1024;
+    info.file = cur.file / 1024;
+    info.kernel = cur.kernel / 1024;
+    info.shmem = cur.shmem / 1024;
+    info.high_events = cur.highEvents;
+    info.max_events = cur.maxEvents;
+    info.oom_events = cur.oomEvents;
+    info.oom_kills = cur.oomKills;
+
+    print("cgroup: %s, usage: %.2f%%, us/sy: %.1f/%.1f, quota: %.2f cpus, throttled: %" PRIu64 "/%" PRIu64 " periods %.3f ms\n", path.c_str(),
+          info.usage, info.user, info.system, info.quota, info.nr_throttled, info.nr_periods, info.throttled_ms);
+    print("cgroup: %s, memory: %" PRIu64 "/%" PRIu64 " kB, anon/file/kernel/shmem: %" PRIu64 "/%" PRIu64 "/%" PRIu64 "/%" PRIu64
+          " kB, high/max/oom/oom_kill: %" PRIu64 "/%" PRIu64 "/%" PRIu64 "/%" PRIu64 "\n",
+          path.c_str(), info.mem_current, info.mem_max, info.anon, info.file, info.kernel, info.shmem, info.high_events, info.max_events,
+          info.oom_events, info.oom_kills);
+    ++iter;
+  }
+}
+
+static bool addMonitorCgroup(const std::string& path) {
+  auto monitor = std::make_unique<CgroupMonitor>(path);
+  CgroupMonitor::Sample sample;  // NOLINT
+  if (!monitor->sample(&sample)) {
+    LOGE("cgroup not found: %s, cgroup v2 root: %s", path.c_str(), CgroupMonitor::root().c_str());
+    return false;
+  }
+  auto& value = s_monitor_cgroups[path];
+  value.monitor = std::move(monitor);
+  value.sample = sample;
+  value.timestampNs = steadyNowNs();
+  value.info.path = path;
+  if (s_argv.e_pressure) addPressureMonitors(value.pressure, path);
+  return true;
+}
+
+static void onUpdateTick(uint64_t missed, uint64_t lateNs) {
+  auto startNs = steadyNowNs();
+  if (missed) {
+    LOGW("update took longer than the interval, missed: %" PRIu64 ", last update: %.3f ms", missed, s_tick_info.work_ms);
+  }
+  s_tick_info.late_ms = lateNs / 1e6f;
+  s_tick_info.missed += missed;
+  s_tick_info.missed_total += missed;
+
+  updateCpu();
+  updateTop();
+  updateWatches();
+  updateProcess();
+  updateCgroups();
+  updatePressure();
+  auto streams = s_streams_wanted.load();
+  if (streams) {
+    auto snapshot = std::make_unique<Snapshot>();
+    collectPluginsInfos(*snapshot, streams);
+    collectNowInfos(*snapshot, streams);
+    s_tick_info.timestamps = utils::getTimestamps();
+    snapshot->tick = std::make_unique<msg::TickInfo>(s_tick_info);
+    s_tick_info.missed = 0;
+    pushSnapshot(std::move(snapshot));
+  }
+  s_tick_info.work_ms = (steadyNowNs() - startNs) / 1e6f;
+}
+
 [[noreturn]] static void monitorCpu() {
   auto& cpu = *s_monitor_cpu;
   for (;;) {
-    std::this_thread::sleep_for(std::chrono::milliseconds(s_argv.d_update_interval_ms));
+    std::this_thread::sleep_for(std::chrono::nanoseconds((int64_t)(s_argv.d_update_interval_ms * 1e6)));
     cpu.update();
-    printf("%s usage: %.2f%%\n", cpu.ave->name.c_str(), cpu.ave->usage);
+    auto print = [](const CpuMonitorCore& core) {
+      if (!core.online) {
+        printf("%-6s offline\n", core.name.c_str());
+        return;
+      }
+      auto& t = core.times;
+      printf("%-6s usage: %6.2f%%, us/ni/sy/wa/hi/si/st: %.1f/%.1f/%.1f/%.1f/%.1f/%.1f/%.1f\n", core.name.c_str(), core.usage, t[CpuT::USER],
+             t[CpuT::NICE], t[CpuT::SYSTEM], t[CpuT::IOWAIT], t[CpuT::IRQ], t[CpuT::SOFTIRQ], t[CpuT::STEAL]);
+    };
+    print(*cpu.ave);
     for (auto& item : cpu.cores) {
-      printf("%s usage: %.2f%%\n", item->name.c_str(), item->usage);
+      print(*item);
     }
     printf("\n");
   }
@@ -397,11 +1465,69 @@ static void asyncNextUpdate() {
 
 static void initApp() {
   s_context = std::make_unique<asio::io_context>();
-  s_timer_update = std::make_unique<asio::steady_timer>(*s_context);
-  asyncNextUpdate();
+  auto interval = std::chrono::nanoseconds((int64_t)(s_argv.d_update_interval_ms * 1e6));
+  s_timer_update = std::make_unique<utils::TickTimer>(*s_context, interval);
+  s_tick_info.interval_ms = s_argv.d_update_interval_ms;
+
+  s_proc_events = std::make_unique<ProcEvents>();
+  if (s_proc_events->open()) {
+    // the descriptor is closed by asio, keep ProcEvents its own
+    s_proc_events_stream = std::make_unique<asio::posix::stream_descriptor>(*s_context, dup(s_proc_events->fd()));
+    asyncWaitProcEvents();
+  } else {
+    LOGW("proc events not available: %s, fallback to polling", strerror(errno));
+    s_proc_events = nullptr;
+  }
+
+  if (s_argv.e_pressure) {
+    addPressureMonitors(s_monitor_pressure, {});
+    if (s_monitor_pressure.empty()) {
+      LOGW("pressure stall information not available: %s", strerror(errno));
+      s_argv.e_pressure = false;
+    }
+  }
+  for (const auto& spec : string_utils::Split(s_argv.e_pressure_triggers, ",", true)) {
+    LOGD("add pressure trigger: %s", spec.c_str());
+    msg::PressureRule rule;
+    if (!parsePressureRule(spec, &rule)) {
+      LOGE("invalid pressure trigger: %s", spec.c_str());
+      continue;
+    }
+    addPressureTrigger(rule);
+  }
+
+  s_timer_update->start(onUpdateTick);
+}
+
+static void raiseFdLimit() {
+  // a stat file of every monitored thread is kept open by ProcessTaskSampler, the soft limit is often only 1024
+  rlimit limit{};
+  if (getrlimit(RLIMIT_NOFILE, &limit) != 0 || limit.rlim_cur >= limit.rlim_max) return;
+  limit.rlim_cur = limit.rlim_max;
+  if (setrlimit(RLIMIT_NOFILE, &limit) != 0) LOGW("raise fd limit failed: %s", strerror(errno));
+}
+
+static void initSampleThread() {
+#ifdef __linux__
+  pthread_setname_np(pthread_self(), "sampler");
+  if (s_argv.b_sample_cpu >= 0) {
+    cpu_set_t cpus;
+    CPU_ZERO(&cpus);
+    CPU_SET(s_argv.b_sample_cpu, &cpus);
+    int ret = pthread_setaffinity_np(pthread_self(), sizeof(cpus), &cpus);
+    if (ret != 0) LOGW("pin sampling thread to cpu %d failed: %s", s_argv.b_sample_cpu, strerror(ret));
+  }
+#endif
+  if (s_argv.F_sample_fifo_priority > 0) {
+    sched_param param{};
+    param.sched_priority = s_argv.F_sample_fifo_priority;
+    int ret = pthread_setschedparam(pthread_self(), SCHED_FIFO, &param);
+    if (ret != 0) LOGW("set SCHED_FIFO %d failed: %s, CAP_SYS_NICE is needed", s_argv.F_sample_fifo_priority, strerror(ret));
+  }
 }
 
 static void runApp() {
+  initSampleThread();
   s_context->run();
 }
 
@@ -409,12 +1535,23 @@ static void showHelp() {
   printf(R"(Usage:
 -h : 打印此帮助
 -v : 打印版本
--d : 刷新间隔/ms 默认1000
+-d : 刷新间隔/ms 默认1000 可为小数 如0.5 按绝对时间调度不随采样耗时漂移 超时错过的刷新会被跳过并告警
 -s : 以服务方式启动 配合GUI使用
 -p : 指定开启的服务端口号
 -c : 仅在终端打印所有CPU核使用率
 -i : 指定监控的PID 半角逗号分隔
--n : 指定监控进程名 半角逗号分隔
+-n : 指定监控进程名 半角逗号分隔 匹配的所有进程都会被监控 可加前缀exe:按可执行文件名 cmdline:按命令行正则匹配
+-t : 通过netlink taskstats采集线程CPU时间(ns精度)和延迟统计 不可用时回退到procfs
+-r : 通过/proc/<tid>/schedstat采集线程CPU时间(ns精度)和运行队列等待时间 适合100ms以下的刷新间隔
+-w : 指定持续监控的进程名 半角逗号分隔 格式同-n 进程重启后自动重新监控
+-f : -w同时监控匹配进程的所有子孙进程
+-g : 指定监控的cgroup v2路径 半角逗号分隔 相对挂载点 如/system.slice/docker-<id>.scope 采集CPU使用率 限流和内存
+-e : 每次刷新采集/proc/pressure和已添加cgroup的PSI 可指定触发器 半角逗号分隔 格式为 资源:some|full:阈值ms:窗口ms[:cgroup] 如-ecpu:some:100:2000 超过阈值时立即上报
+-a : 每次刷新扫描全部进程和线程 输出CPU和RSS排名前N的进程及CPU排名前N的线程 可指定N 默认10
+-m : 定期读取/proc/<pid>/smaps_rollup获取PSS/USS等 可指定间隔/ms 默认5000 (每次刷新只读取/proc/<pid>/statm)
+-q : 安静模式 不在终端打印每次刷新的采样数据 只输出日志 适合-s和大量线程高频刷新
+-b : 将采样线程绑定到指定CPU核 (-s时采样与网络收发在不同线程 网络慢不影响采样间隔)
+-F : 采样线程使用SCHED_FIFO实时调度 指定优先级1-99 需要CAP_SYS_NICE
 )");
 }
 int main(int argc, char** argv) {
@@ -424,7 +1561,7 @@ int main(int argc, char** argv) {
   }
 
   int ret;
-  while ((ret = getopt(argc, argv, "h:v::d:s::p:c::i:n:")) != -1) {
+  while ((ret = getopt(argc, argv, "h:v::d:s::p:c::i:n:t::r::m::w:f::g:e::a::b:F:q::")) != -1) {
     switch (ret) {
       case 'h': {
         showHelp();
@@ -435,8 +1572,13 @@ int main(int argc, char** argv) {
         return 0;
       } break;
       case 'd': {
-        s_argv.d_update_interval_ms = std::stoul(optarg, nullptr, 10);
-        LOGD("update_interval_ms: %u", s_argv.d_update_interval_ms);
+        s_argv.d_update_interval_ms = std::stof(optarg, nullptr);
+        LOGD("update_interval_ms: %.3f", s_argv.d_update_interval_ms);
+        // a zero period would divide by zero in TickTimer, and disarm the timerfd after the first tick
+        if (!(s_argv.d_update_interval_ms * 1e6 >= 1)) {
+          LOGE("invalid update interval: %s", optarg);
+          return 1;
+        }
       } break;
       case 's': {
         s_argv.s_run_server = true;
@@ -454,6 +1596,44 @@ int main(int argc, char** argv) {
       case 'n': {
         s_argv.all_names = optarg;
       } break;
+      case 't': {
+        s_argv.t_use_taskstats = true;
+      } break;
+      case 'r': {
+        s_argv.r_use_schedstat = true;
+      } break;
+      case 'w': {
+        s_argv.w_watch_names = optarg;
+      } break;
+      case 'f': {
+        s_argv.f_watch_children = true;
+      } break;
+      case 'g': {
+        s_argv.all_cgroups = optarg;
+      } break;
+      case 'e': {
+        s_argv.e_pressure = true;
+        if (optarg) s_argv.e_pressure_triggers = optarg;
+      } break;
+      case 'a': {
+        s_argv.a_top_num = optarg ? std::stoul(optarg, nullptr, 10) : 10;
+        LOGD("top_num: %u", s_argv.a_top_num);
+      } break;
+      case 'q': {
+        s_argv.q_quiet = true;
+      } break;
+      case 'b': {
+        s_argv.b_sample_cpu = std::stoi(optarg, nullptr, 10);
+        LOGD("sample_cpu: %d", s_argv.b_sample_cpu);
+      } break;
+      case 'F': {
+        s_argv.F_sample_fifo_priority = std::stoi(optarg, nullptr, 10);
+        LOGD("sample_fifo_priority: %d", s_argv.F_sample_fifo_priority);
+      } break;
+      case 'm': {
+        s_argv.m_mem_rollup_interval_ms = optarg ? std::stoul(optarg, nullptr, 10) : 5000;
+        LOGD("mem_rollup_interval_ms: %u", s_argv.m_mem_rollup_interval_ms);
+      } break;
       default: {
         showHelp();
         return 0;
@@ -461,7 +1641,14 @@ int main(int argc, char** argv) {
     }
   }
 
+  if (s_argv.t_use_taskstats && s_argv.r_use_schedstat) {
+    LOGE("-t and -r can not be used together");
+    return 1;
+  }
+
+  raiseFdLimit();
   s_monitor_cpu = std::make_unique<CpuMonitor>();
+  if (s_argv.a_top_num) s_top_scanner = std::make_unique<TopScanner>(s_argv.a_top_num);
 
   if (!s_argv.all_pids.empty()) {
     for (const auto& pidStr : string_utils::Split(s_argv.all_pids, ",", true)) {
@@ -478,6 +1665,23 @@ int main(int argc, char** argv) {
     }
   }
 
+  if (!s_argv.all_cgroups.empty()) {
+    for (const auto& path : string_utils::Split(s_argv.all_cgroups, ",", true)) {
+      LOGD("add cgroup: %s", path.c_str());
+      addMonitorCgroup(path);
+    }
+  }
+
+  if (!s_argv.w_watch_names.empty()) {
+    for (const auto& name : string_utils::Split(s_argv.w_watch_names, ",", true)) {
+      LOGD("add watch: %s", name.c_str());
+      msg::WatchRule rule;
+      rule.name = name;
+      rule.children = s_argv.f_watch_children;
+      if (!addWatch(rule)) LOGE("invalid watch pattern: %s", name.c_str());
+    }
+  }
+
   if (s_argv.c_only_monitor_cpu) {
     monitorCpu();
   }
@@ -0,0 +1,203 @@
+#include <cmath>
+#include <cstdio>
+#include <string>
+
+#include "BinaryMsg.h"
+#include "assert_def.h"
+
+using namespace cpu_monitor;
+using namespace cpu_monitor::msg;
+
+static ThreadInfo makeThread(uint64_t id, const std::string& name, float usage) {
+  ThreadInfo info;
+  info.id = id;
+  info.name = name;
+  info.usage = usage;
+  info.latency = 1.5f;
+  info.min_flt = 10;
+  info.ctx_switches = 100;
+  info.invol_ctx_switches = -1;
+  return info;
+}
+
+static const ThreadInfo* findThread(const ProcessInfo& info, uint64_t id) {
+  for (const auto& thread : info.thread_infos) {
+    if (thread.id == id) return &thread;
+  }
+  return nullptr;
+}
+
+static bool isKeyFrame(const std::string& frame) {
+  return frame.size() > 2 && (frame[2] & binary::KEY);
+}
+
+static void assertSameEvents(const std::vector<ThreadEvent>& events, const std::vector<ThreadEvent>& decoded) {
+  ASSERT(decoded.size() == events.size());
+  for (size_t i = 0; i < events.size(); ++i) {
+    ASSERT(decoded[i].id == events[i].id);
+    ASSERT(decoded[i].name == events[i].name);
+    ASSERT(decoded[i].exit == events[i].exit);
+    ASSERT(decoded[i].timestamps == events[i].timestamps);
+  }
+}
+
+// the decoded process has exactly `msg` threads with the same values
+static void assertSame(const ProcessMsg& msg, const ProcessMsg& decoded) {
+  ASSERT(decoded.timestamps == msg.timestamps);
+  ASSERT(decoded.infos.size() == msg.infos.size());
+  for (size_t i = 0; i < msg.infos.size(); ++i) {
+    const auto& info = msg.infos[i];
+    const auto& out = decoded.infos[i];
+    ASSERT(out.id == info.id && out.name == info.name);
+    ASSERT(out.mem_info.rss == info.mem_info.rss);
+    ASSERT(out.thread_infos.size() == info.thread_infos.size());
+    for (const auto& thread : info.thread_infos) {
+      auto outThread = findThread(out, thread.id);
+      ASSERT(outThread);
+      ASSERT(outThread->name == thread.name);
+      ASSERT(std::fabs(outThread->usage - thread.usage) < 0.01f);
+      ASSERT(std::fabs(outThread->latency - thread.latency) < 0.001f);
+      ASSERT(outThread->min_flt == thread.min_flt);
+      ASSERT(outThread->ctx_switches == thread.ctx_switches);
+      ASSERT(outThread->invol_ctx_switches == thread.invol_ctx_switches);
+    }
+    assertSameEvents(info.thread_events, out.thread_events);
+  }
+  ASSERT(decoded.gone_infos.size() == msg.gone_infos.size());
+  for (size_t i = 0; i < msg.gone_infos.size(); ++i) {
+    ASSERT(decoded.gone_infos[i].id == msg.gone_infos[i].id && decoded.gone_infos[i].name == msg.gone_infos[i].name);
+    assertSameEvents(msg.gone_infos[i].thread_events, decoded.gone_infos[i].thread_events);
+  }
+}
+
+int main() {
+  binary::Encoder encoder;
+  binary::Decoder decoder;
+
+  ProcessMsg msg;
+  msg.timestamps = 1000;
+  msg.infos.emplace_back();
+  auto& info = msg.infos.back();
+  info.id = 100;
+  info.name = "server";
+  info.mem_info.rss = 4096;
+  info.thread_infos = {makeThread(100, "server", 1.5f), makeThread(101, "worker", 20), makeThread(102, "worker", 0)};
+
+  printf("=> key frame\n");
+  {
+    CpuMsg cpu;
+    cpu.ave.name = "cpu";
+    cpu.ave.usage = 12.34f;
+    cpu.ave.timestamps = 1000;
+    cpu.cores.resize(2);
+    cpu.cores[0].name = "cpu0";
+    cpu.cores[1].name = "cpu1";
+    cpu.cores[1].online = false;
+    auto frame = encoder.encode(cpu);
+    ASSERT(isKeyFrame(frame));
+    CpuMsg out;
+    ASSERT(decoder.decode(frame, &out));
+    ASSERT(out.ave.name == "cpu" && std::fabs(out.ave.usage - 12.34f) < 0.01f);
+    ASSERT(out.cores.size() == 2 && out.cores[1].name == "cpu1" && !out.cores[1].online);
+
+    ProcessMsg decoded;
+    ASSERT(decoder.decode(encoder.encode(msg), &decoded));
+    assertSame(msg, decoded);
+  }
+
+  printf("=> delta frame\n");
+  {
+    msg.timestamps = 2000;
+    info.thread_infos[1].usage = 30;
+    auto frame = encoder.encode(msg);
+    ASSERT(!isKeyFrame(frame));
+    ProcessMsg decoded;
+    ASSERT(decoder.decode(frame, &decoded));
+    assertSame(msg, decoded);
+
+    // nothing changed: no thread is sent
+    auto same = encoder.encode(msg);
+    ASSERT(same.size() < frame.size());
+    ASSERT(decoder.decode(same, &decoded));
+    assertSame(msg, decoded);
+  }
+
+  printf("=> thread add and remove, name reuse\n");
+  {
+    msg.timestamps = 3000;
+    info.thread_infos.erase(info.thread_infos.begin() + 2);
+    // a new thread and a rename to names sent before
+    info.thread_infos.push_back(makeThread(103, "worker", 5));
+    info.thread_infos[0].name = "worker";
+    ThreadEvent exit;
+    exit.id = 102;
+    exit.name = "worker";
+    exit.exit = true;
+    exit.timestamps = 2500;
+    info.thread_events = {exit};
+    ProcessMsg decoded;
+    ASSERT(decoder.decode(encoder.encode(msg), &decoded));
+    assertSame(msg, decoded);
+    ASSERT(!findThread(decoded.infos[0], 102));
+    info.thread_events.clear();
+  }
+
+  printf("=> events of a gone process\n");
+  {
+    msg.timestamps = 3500;
+    msg.gone_infos.emplace_back();
+    auto& gone = msg.gone_infos.back();
+    gone.id = 200;
+    gone.name = "client";
+    ThreadEvent start;
+    start.id = 201;
+    start.name = "worker";
+    start.timestamps = 3100;
+    ThreadEvent exit = start;
+    exit.exit = true;
+    exit.timestamps = 3200;
+    gone.thread_events = {start, exit};
+    ProcessMsg decoded;
+    ASSERT(decoder.decode(encoder.encode(msg), &decoded));
+    assertSame(msg, decoded);
+    msg.gone_infos.clear();
+    // not a process with threads of the decoder
+    ASSERT(decoder.decode(encoder.encode(msg), &decoded));
+    assertSame(msg, decoded);
+  }
+
+  printf("=> decoder joining mid-stream\n");
+  {
+    binary::Decoder late;
+    ProcessMsg decoded;
+    ASSERT(!late.decode(encoder.encode(msg), &decoded));
+    // what the daemon does on set_encoding
+    encoder.reset();
+    auto frame = encoder.encode(msg);
+    ASSERT(isKeyFrame(frame));
+    ASSERT(late.decode(frame, &decoded));
+    assertSame(msg, decoded);
+    ASSERT(decoder.decode(frame, &decoded));
+    assertSame(msg, decoded);
+  }
+
+  printf("=> names of exited threads are dropped\n");
+  {
+    size_t keyFrames = 0;
+    for (int i = 0; i < 5000; ++i) {
+      msg.timestamps += 1000;
+      info.thread_infos[2] = makeThread(1000 + i, "task-" + std::to_string(i), 1);
+      auto frame = encoder.encode(msg);
+      if (isKeyFrame(frame)) ++keyFrames;
+      ProcessMsg decoded;
+      ASSERT(decoder.decode(frame, &decoded));
+      assertSame(msg, decoded);
+    }
+    // 3 live names, the tables are dropped every ~1000 names
+    printf("key frames: %zu\n", keyFrames);
+    ASSERT(keyFrames >= 4 && keyFrames <= 5);
+  }
+
+  printf("all tests passed\n");
+  return 0;
+}
@@ -0,0 +1,9 @@
+#include "async_log.h"
+
+int log_printf_async(const char* fmt, ...) {
+  va_list args;
+  va_start(args, fmt);
+  utils::AsyncLog::instance().vprint(fmt, args);
+  va_end(args);
+  return 0;
+}
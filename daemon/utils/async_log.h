@@ -0,0 +1,122 @@
+#pragma once
+
+#include <atomic>
+#include <chrono>
+#include <condition_variable>
+#include <cstdarg>
+#include <cstdio>
+#include <cstdlib>
+#include <mutex>
+#include <new>
+#include <thread>
+
+namespace utils {
+
+/**
+ * lines are formatted by the calling thread into a bounded lock-free ring, and written to stdout by a background thread
+ * so a slow terminal or journald never blocks the caller, lines are dropped and counted when the ring is full
+ * any number of producer threads, lines longer than LineSize are truncated
+ */
+class AsyncLog {
+  static const size_t Capacity = 1024;
+  static const size_t LineSize = 512;
+
+ public:
+  static AsyncLog& instance() {
+    // never deleted, the writer thread and atexit may still use it during static destruction
+    static AsyncLog* log = new AsyncLog();
+    return *log;
+  }
+
+  void vprint(const char* fmt, va_list args) {
+    size_t pos = tail_.load(std::memory_order_relaxed);
+    Slot* slot;
+    for (;;) {
+      slot = &slots_[pos & (Capacity - 1)];
+      auto diff = (intptr_t)slot->seq.load(std::memory_order_acquire) - (intptr_t)pos;
+      if (diff == 0) {
+        if (tail_.compare_exchange_weak(pos, pos + 1, std::memory_order_relaxed)) break;
+      } else if (diff < 0) {
+        dropped_.fetch_add(1, std::memory_order_relaxed);
+        return;
+      } else {
+        pos = tail_.load(std::memory_order_relaxed);
+      }
+    }
+
+    int len = vsnprintf(slot->text, LineSize, fmt, args);
+    slot->len = len < 0 ? 0 : len < (int)LineSize ? len : LineSize - 1;
+    slot->seq.store(pos + 1, std::memory_order_release);
+
+    if (!notified_.exchange(true, std::memory_order_acq_rel)) cv_.notify_one();
+  }
+
+  /**
+   * write all lines queued so far, on the calling thread
+   */
+  void flush() {
+    std::lock_guard<std::mutex> lock(writeMutex_);
+    bool wrote = false;
+    for (;;) {
+      auto& slot = slots_[head_ & (Capacity - 1)];
+      if (slot.seq.load(std::memory_order_acquire) != head_ + 1) break;
+      fwrite(slot.text, 1, slot.len, stdout);
+      slot.seq.store(head_ + Capacity, std::memory_order_release);
+      ++head_;
+      wrote = true;
+    }
+    auto dropped = dropped_.load(std::memory_order_relaxed);
+    if (dropped != droppedReported_) {
+      fprintf(stdout, "async log: %llu lines dropped\n", (unsigned long long)(dropped - droppedReported_));
+      droppedReported_ = dropped;
+      wrote = true;
+    }
+    if (wrote) fflush(stdout);
+  }
+
+ private:
+  AsyncLog() {
+    for (size_t i = 0; i < Capacity; ++i) {
+      slots_[i].seq.store(i, std::memory_order_relaxed);
+    }
+    std::thread([this] {
+      for (;;) {
+        notified_.store(false, std::memory_order_release);
+        flush();
+        std::unique_lock<std::mutex> lock(waitMutex_);
+        // notify_one() is called without the lock and may be missed, the timeout bounds the delay
+        cv_.wait_for(lock, std::chrono::milliseconds(100), [this] {
+          return notified_.load(std::memory_order_acquire);
+        });
+      }
+    }).detach();
+    atexit([] {
+      instance().flush();
+    });
+  }
+
+ private:
+  struct Slot {
+    std::atomic<size_t> seq{0};  // pos: free for the producer of pos, pos + 1: written
+    size_t len = 0;
+    char text[LineSize];
+  };
+
+  alignas(64) std::atomic<size_t> tail_{0};
+  alignas(64) size_t head_ = 0;  // under writeMutex_
+  std::atomic<uint64_t> dropped_{0};
+  uint64_t droppedReported_ = 0;
+  std::atomic<bool> notified_{false};
+  std::mutex writeMutex_;
+  std::mutex waitMutex_;
+  std::condition_variable cv_;
+  Slot slots_[Capacity];
+};
+
+}  // namespace utils
+
+/**
+ * the L_O_G_PRINTF_CUSTOM of log.h, see daemon/CMakeLists.txt
+ * defined in async_log.cpp, which every daemon executable compiles since cpu_monitor_lib calls it too
+ */
+int log_printf_async(const char* fmt, ...);
@@ -0,0 +1,108 @@
+#pragma once
+
+#include <chrono>
+#include <cstdint>
+#include <functional>
+#include <memory>
+
+#ifdef __linux__
+#include <sys/timerfd.h>
+#include <unistd.h>
+#endif
+
+#include "asio.hpp"
+
+namespace utils {
+
+/**
+ * periodic timer on absolute deadlines, the period does not stretch by the time of the handler
+ * deadlines passed while the handler was running are skipped and reported as missed, instead of firing in a burst
+ * on linux the period is kept by a timerfd in the kernel, no re-arming between ticks, fine for sub-ms intervals
+ */
+class TickTimer {
+ public:
+  using Clock = std::chrono::steady_clock;
+  /**
+   * @param missed ticks skipped just before this one
+   * @param lateNs from the deadline of this tick to the call
+   */
+  using Handler = std::function<void(uint64_t missed, uint64_t lateNs)>;
+
+  TickTimer(asio::io_context& context, std::chrono::nanoseconds interval) : interval_(interval), timer_(context) {
+#ifdef __linux__
+    int fd = timerfd_create(CLOCK_MONOTONIC, TFD_NONBLOCK | TFD_CLOEXEC);
+    if (fd >= 0) stream_ = std::make_unique<asio::posix::stream_descriptor>(context, fd);
+#endif
+  }
+
+  void start(Handler handler) {
+    handler_ = std::move(handler);
+    // steady_clock is CLOCK_MONOTONIC on linux, deadlines of both timers are comparable
+    deadline_ = Clock::now();
+#ifdef __linux__
+    if (stream_) {
+      auto toTimespec = [](std::chrono::nanoseconds ns) {
+        timespec ts{};
+        ts.tv_sec = ns.count() / 1000000000;
+        ts.tv_nsec = ns.count() % 1000000000;
+        return ts;
+      };
+      itimerspec spec{};
+      spec.it_interval = toTimespec(interval_);
+      spec.it_value = toTimespec((deadline_ + interval_).time_since_epoch());
+      if (timerfd_settime(stream_->native_handle(), TFD_TIMER_ABSTIME, &spec, nullptr) == 0) {
+        asyncWaitFd();
+        return;
+      }
+      stream_ = nullptr;
+    }
+#endif
+    asyncWaitTimer();
+  }
+
+  std::chrono::nanoseconds interval() const {
+    return interval_;
+  }
+
+ private:
+  void onTick(uint64_t expirations) {
+    deadline_ += interval_ * (int64_t)expirations;
+    auto late = Clock::now() - deadline_;
+    handler_(expirations - 1, late.count() > 0 ? (uint64_t)std::chrono::duration_cast<std::chrono::nanoseconds>(late).count() : 0);
+  }
+
+  void asyncWaitTimer() {
+    timer_.expires_at(deadline_ + interval_);
+    timer_.async_wait([this](asio::error_code ec) {
+      if (ec) return;
+      auto next = deadline_ + interval_;
+      auto now = Clock::now();
+      onTick(now > next ? (now - next) / interval_ + 1 : 1);
+      asyncWaitTimer();
+    });
+  }
+
+#ifdef __linux__
+  void asyncWaitFd() {
+    stream_->async_wait(asio::posix::stream_descriptor::wait_read, [this](asio::error_code ec) {
+      if (ec) return;
+      uint64_t expirations = 0;
+      if (read(stream_->native_handle(), &expirations, sizeof(expirations)) == sizeof(expirations) && expirations > 0) {
+        onTick(expirations);
+      }
+      asyncWaitFd();
+    });
+  }
+#endif
+
+ private:
+  std::chrono::nanoseconds interval_;
+  Clock::time_point deadline_;  // of the last tick
+  Handler handler_;
+  asio::steady_timer timer_;
+#ifdef __linux__
+  std::unique_ptr<asio::posix::stream_descriptor> stream_;
+#endif
+};
+
+}  // namespace utils
@@ -0,0 +1,98 @@
+#pragma once
+
+#include <cstdint>
+#include <string>
+#include <vector>
+
+#include "Types.h"
+#include "detail/noncopyable.hpp"
+
+#ifdef __linux__
+#include "detail/proc_file.h"
+#endif
+
+namespace cpu_monitor {
+
+/**
+ * Cpu time, throttling and memory of a cgroup v2, e.g. a container
+ * the files are kept open between samples, a controller that is not enabled for the cgroup reads as 0
+ * other platforms: not supported, sample() returns false
+ */
+class CgroupMonitor : detail::noncopyable {
+ public:
+  struct Sample {
+    // cpu.stat, totals
+    uint64_t usageUsec;
+    uint64_t userUsec;
+    uint64_t systemUsec;
+    uint64_t nrPeriods;  // enforcement periods elapsed, 0 without a quota
+    uint64_t nrThrottled;
+    uint64_t throttledUsec;
+
+    // cpu.max, quotaUsec is 0 if there is no limit
+    uint64_t quotaUsec;
+    uint64_t periodUsec;
+
+    // bytes, memory.max is 0 if there is no limit
+    uint64_t memCurrent;
+    uint64_t memMax;
+
+    // memory.stat, bytes
+    uint64_t anon;
+    uint64_t file;
+    uint64_t kernel;
+    uint64_t shmem;
+
+    // memory.events, totals
+    uint64_t highEvents;  // times the usage was over memory.high and reclaim was forced
+    uint64_t maxEvents;   // times the usage was about to go over memory.max
+    uint64_t oomEvents;
+    uint64_t oomKills;
+  };
+
+ public:
+  /**
+   * mount point of the cgroup v2 hierarchy, like /sys/fs/cgroup or /sys/fs/cgroup/unified
+   * @return empty if not mounted
+   */
+  static std::string root();
+
+  /**
+   * @return the cgroup v2 path of a process relative to root(), like /system.slice/docker-<id>.scope, empty if not found
+   */
+  static std::string pathOfPid(PID_t pid);
+
+  /**
+   * @param path relative to root(), or an absolute directory path under it
+   * @return the absolute directory of a cgroup with a trailing slash, empty if cgroup v2 is not mounted
+   */
+  static std::string dir(const std::string &path);
+
+ public:
+  /**
+   * @param path like dir()
+   */
+  explicit CgroupMonitor(const std::string &path);
+
+  /**
+   * @return false if the cgroup does not exist or has been removed
+   */
+  bool sample(Sample *sample);
+
+ public:
+  const std::string path;  // as given
+
+#ifdef __linux__
+ private:
+  std::string dir_;
+  detail::ProcFile cpuStatFile_;
+  detail::ProcFile cpuMaxFile_;
+  detail::ProcFile memCurrentFile_;
+  detail::ProcFile memMaxFile_;
+  detail::ProcFile memStatFile_;
+  detail::ProcFile memEventsFile_;
+  std::vector<char> buf_;
+#endif
+};
+
+}  // namespace cpu_monitor
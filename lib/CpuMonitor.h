@@ -4,13 +4,31 @@
 #include <vector>
 
 #include "CpuMonitorCore.h"
+#include "CpuTable.h"
 #include "detail/noncopyable.hpp"
 
+#ifdef __linux__
+#include "detail/proc_file.h"
+#endif
+
 namespace cpu_monitor {
 
+/**
+ * Ticks of all cores are kept in one CpuTable, `ave` and `cores` are views of its rows updated after each update
+ * `cores[i]` is always the core with id i, cores are added when a new id shows up and kept with `online` false while offline
+ */
 class CpuMonitor : detail::noncopyable {
  public:
-  explicit CpuMonitor();
+  /**
+   * how /proc/stat is read, only used on linux
+   */
+  enum class ReadMode {
+    PREAD,  // keep /proc/stat open, pread it into a reusable buffer and parse in place
+    STDIO,  // fopen/fscanf /proc/stat on every update
+  };
+
+ public:
+  explicit CpuMonitor(ReadMode mode = ReadMode::PREAD);
 
   void update(bool updateCores = true);
   void dump() const;
@@ -18,6 +36,41 @@ class CpuMonitor : detail::noncopyable {
  public:
   std::unique_ptr<CpuMonitorCore> ave;
   std::vector<std::unique_ptr<CpuMonitorCore>> cores;
+
+ private:
+  /**
+   * add offline cores up to `num`
+   */
+  void resizeCores(size_t num);
+
+  /**
+   * calculate rows [0, rows) of the table and update the views, row 0 is `ave`, row i + 1 is `cores[i]`
+   */
+  void updateViews(size_t rows);
+
+ private:
+  CpuTable table_;
+
+#ifdef __linux__
+ private:
+  void updateByStdio(bool updateCores);
+  void updateByPread(bool updateCores);
+  void setTicks(const detail::CpuStat &stat);
+  void setAllOffline();
+
+ private:
+  ReadMode readMode_;
+  detail::ProcFile statFile_;
+  std::vector<char> statBuf_;
+#endif
+
+#ifdef __APPLE__
+ private:
+  void setTicks(size_t row, const natural_t *cpuTicks);
+
+ private:
+  std::vector<uint64_t> machTicks_;  // [row * CPU_STATE_MAX + state], natural_t ticks extended to 64 bits
+#endif
 };
 
 }  // namespace cpu_monitor
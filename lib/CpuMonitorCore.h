@@ -10,17 +10,29 @@
 
 namespace cpu_monitor {
 
+#ifdef __linux__
+namespace detail {
+struct CpuStat;
+}
+#endif
+
 class CpuMonitorCore : detail::noncopyable {
  public:
   explicit CpuMonitorCore();
 
  public:
   void update(CpuInfoNative *p);
+#ifdef __linux__
+  void update(const detail::CpuStat &stat);
+#endif
   void dump() const;
 
  public:
   std::string name;
+  int id = -1;          // N of `cpuN`, -1 for the average of all cores
+  bool online = true;   // false: the core is offline, usage and times are 0
   float usage{};
+  float times[CpuT::TYPE_NUM]{};  // percentage of each CpuT category during the last interval
 
   uint64_t idleTime{};
   uint64_t totalTime{};
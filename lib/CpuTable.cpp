@@ -0,0 +1,94 @@
+#include "CpuTable.h"
+
+#include <algorithm>
+
+namespace cpu_monitor {
+
+CpuTable::CpuTable(size_t rows) {
+  resize(rows);
+}
+
+void CpuTable::resize(size_t rows) {
+  // columns are stored one after another, move each of them to its new offset
+  std::vector<uint64_t> cur(CpuT::TYPE_NUM * rows);
+  std::vector<uint64_t> prev(CpuT::TYPE_NUM * rows);
+  auto keep = (ptrdiff_t)std::min(rows, rows_);
+  for (int type = 0; type < CpuT::TYPE_NUM; ++type) {
+    std::copy_n(cur_.cbegin() + type * (ptrdiff_t)rows_, keep, cur.begin() + type * (ptrdiff_t)rows);
+    std::copy_n(prev_.cbegin() + type * (ptrdiff_t)rows_, keep, prev.begin() + type * (ptrdiff_t)rows);
+  }
+  cur_.swap(cur);
+  prev_.swap(prev);
+  totalDelta_.resize(rows);
+  idleDelta_.resize(rows);
+  usage_.resize(rows);
+  scale_.resize(rows);
+  curSum_.resize(rows);
+  prevSum_.resize(rows);
+  times_.assign(CpuT::TYPE_NUM * rows, 0);
+  rows_ = rows;
+}
+
+void CpuTable::update(size_t rows) {
+  rows = std::min(rows, rows_);
+  auto total = totalDelta_.data();
+  auto idle = idleDelta_.data();
+  auto usage = usage_.data();
+  auto scale = scale_.data();
+  auto curSum = curSum_.data();
+  auto prevSum = prevSum_.data();
+  std::fill_n(total, rows, 0);
+  std::fill_n(idle, rows, 0);
+  std::fill_n(curSum, rows, 0);
+
+  // ticks are subtracted in 64 bits, the delta of one interval fits 31 bits
+  // so deltas are summed and converted to float with 32-bit SIMD lanes
+  for (int type = 0; type < CpuT::TYPE_NUM; ++type) {
+    auto cur = cur_.data() + type * rows_;
+    auto prev = prev_.data() + type * rows_;
+    auto times = times_.data() + type * rows_;
+    uint32_t idleMask = type == CpuT::IDLE || type == CpuT::IOWAIT ? ~0u : 0;
+    for (size_t i = 0; i < rows; ++i) {
+      auto delta = (int32_t)(uint32_t)(cur[i] - prev[i]);
+      // a single category may step back a little (e.g. iowait), count it as 0
+      delta &= ~(delta >> 31);
+      total[i] += delta;
+      idle[i] += delta & idleMask;
+      times[i] = (float)delta;
+      prev[i] = cur[i];
+    }
+  }
+
+  // summed in a separate pass, one more array puts the loop above over the alias check limit of the vectorizer
+  for (int type = 0; type < CpuT::TYPE_NUM; ++type) {
+    auto cur = cur_.data() + type * rows_;
+    for (size_t i = 0; i < rows; ++i) {
+      curSum[i] += cur[i];
+    }
+  }
+
+  for (size_t i = 0; i < rows; ++i) {
+    // the counters restarted (cpu hotplug, suspend, the `cpu` line losing an offline core): start over from the current ticks
+    uint32_t keep = -(uint32_t)(curSum[i] >= prevSum[i]);
+    prevSum[i] = curSum[i];
+    total[i] &= keep;
+    idle[i] &= keep;
+  }
+
+  for (size_t i = 0; i < rows; ++i) {
+    // 0 / 1 and a zero scale if no tick has passed
+    auto totalTicks = (float)(int32_t)(total[i] | (total[i] == 0));
+    auto activeTicks = (float)(int32_t)(total[i] - idle[i]);
+    scale[i] = (float)(int32_t)(100 & -(uint32_t)(total[i] != 0)) / totalTicks;
+    usage[i] = activeTicks * scale[i];
+  }
+
+  for (int type = 0; type < CpuT::TYPE_NUM; ++type) {
+    auto times = times_.data() + type * rows_;
+    for (size_t i = 0; i < rows; ++i) {
+      times[i] *= scale[i];
+    }
+  }
+}
+
+}  // namespace cpu_monitor
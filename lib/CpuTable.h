@@ -0,0 +1,81 @@
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+#include <vector>
+
+#include "CpuTick.h"
+#include "detail/noncopyable.hpp"
+
+namespace cpu_monitor {
+
+/**
+ * Ticks of all cpus in one table, one 64-bit column per CpuT category
+ * deltas, usage and the percentage of each category of all rows are calculated in plain loops over the columns
+ */
+class CpuTable : detail::noncopyable {
+ public:
+  explicit CpuTable(size_t rows = 0);
+
+  void resize(size_t rows);
+
+  size_t rows() const {
+    return rows_;
+  }
+
+  /**
+   * set the current ticks of a row
+   * @param ticks CpuT::TYPE_NUM values in CpuT order
+   */
+  void setTicks(size_t row, const uint64_t *ticks) {
+    for (int type = 0; type < CpuT::TYPE_NUM; ++type) {
+      cur_[type * rows_ + row] = ticks[type];
+    }
+  }
+
+  /**
+   * calculate deltas and usage of rows [0, rows), then the current ticks become the previous ones
+   * a row whose ticks went backwards in total is taken as restarted and reports no tick for this interval
+   */
+  void update(size_t rows);
+
+  void update() {
+    update(rows_);
+  }
+
+  float usage(size_t row) const {
+    return usage_[row];
+  }
+
+  /**
+   * ticks of the last interval
+   */
+  uint64_t totalTime(size_t row) const {
+    return totalDelta_[row];
+  }
+
+  uint64_t idleTime(size_t row) const {
+    return idleDelta_[row];
+  }
+
+  /**
+   * percentage of a CpuT category during the last interval
+   */
+  float time(size_t row, int type) const {
+    return times_[type * rows_ + row];
+  }
+
+ private:
+  size_t rows_ = 0;
+  std::vector<uint64_t> cur_;   // [type * rows_ + row]
+  std::vector<uint64_t> prev_;  // [type * rows_ + row]
+  std::vector<uint32_t> totalDelta_;
+  std::vector<uint32_t> idleDelta_;
+  std::vector<float> usage_;
+  std::vector<float> scale_;      // 100 / total ticks, 0 if the counters restarted
+  std::vector<uint64_t> curSum_;  // sum of all categories, to detect counter resets
+  std::vector<uint64_t> prevSum_;
+  std::vector<float> times_;  // [type * rows_ + row]
+};
+
+}  // namespace cpu_monitor
@@ -4,9 +4,45 @@
 
 namespace cpu_monitor {
 
+/**
+ * cpu time categories, in the order of /proc/stat
+ */
+namespace CpuT {
+enum : int {
+  USER = 0,
+  NICE,
+  SYSTEM,
+  IDLE,
+  IOWAIT,
+  IRQ,
+  SOFTIRQ,
+  STEAL,
+  GUEST,
+  GUEST_NICE,
+  TYPE_NUM,
+};
+}
+
+/**
+ * cumulative ticks, kept in 64 bits: the `cpu` line of /proc/stat passes 2^32 after weeks of uptime on many-core machines
+ */
 struct CpuTick {
-  uint32_t idleTicks = 0;
-  uint32_t totalTicks = 0;
+  uint64_t ticks[CpuT::TYPE_NUM]{};
+  uint64_t totalTicks = 0;
+
+  /**
+   * the counters restarted, e.g. after cpu hotplug or suspend
+   */
+  bool isResetFrom(const CpuTick &pre) const {
+    return totalTicks < pre.totalTicks;
+  }
 };
 
+/**
+ * delta of a counter, a single category may step back a little (e.g. iowait), which counts as 0
+ */
+inline uint64_t calcTickDelta(uint64_t cur, uint64_t pre) {
+  return cur > pre ? cur - pre : 0;
+}
+
 }  // namespace cpu_monitor
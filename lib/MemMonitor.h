@@ -5,10 +5,15 @@
 #include <cstdint>
 
 #include "Types.h"
+#include "detail/noncopyable.hpp"
+
+#ifdef __linux__
+#include "detail/proc_file.h"
+#endif
 
 namespace cpu_monitor {
 
-class MemMonitor {
+class MemMonitor : detail::noncopyable {
  public:
   // KB
   struct Usage {
@@ -23,10 +28,56 @@ class MemMonitor {
     Usage usage;
   };
 
+  // KB, from /proc/<pid>/statm: one line of numbers, cheap enough for every update
+  struct Statm {
+    size_t VmSize;
+    size_t VmRSS;
+    size_t shared;  // RssFile + RssShmem
+    size_t text;
+    size_t data;  // data + stack
+  };
+
+  // KB, from /proc/<pid>/smaps_rollup and status: the kernel walks all mappings, read it at a lower frequency
+  struct Rollup {
+    size_t Pss;
+    size_t Uss;  // Private_Clean + Private_Dirty
+    size_t RssAnon;
+    size_t RssFile;
+    size_t RssShmem;
+    size_t Swap;
+  };
+
  public:
   static UsageRet getUsage(PID_t pid = 0);
 
   static void dumpUsage(PID_t pid = 0);
+
+ public:
+  /**
+   * keep the files of `pid` open between samples
+   */
+  explicit MemMonitor(PID_t pid = 0);
+
+  /**
+   * @return false if the process has exited
+   */
+  bool sampleStatm(Statm *statm);
+
+  /**
+   * @return false if the process has exited, is not readable or smaps_rollup is not supported (linux < 4.14, macOS), `rollup` is unchanged then
+   */
+  bool sampleRollup(Rollup *rollup);
+
+ public:
+  const PID_t pid;
+
+#ifdef __linux__
+ private:
+  detail::ProcFile statmFile_;
+  detail::ProcFile rollupFile_;
+  detail::ProcFile statusFile_;
+  std::vector<char> buf_;
+#endif
 };
 
 }  // namespace cpu_monitor
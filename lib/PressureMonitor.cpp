@@ -0,0 +1,27 @@
+#include "PressureMonitor.h"
+
+namespace cpu_monitor {
+
+const char *PressureMonitor::name(Resource resource) {
+  switch (resource) {
+    case Resource::CPU:
+      return "cpu";
+    case Resource::MEMORY:
+      return "memory";
+    case Resource::IO:
+      return "io";
+  }
+  return "";
+}
+
+bool PressureMonitor::parse(const std::string &name, Resource *resource) {
+  for (auto item : {Resource::CPU, Resource::MEMORY, Resource::IO}) {
+    if (name == PressureMonitor::name(item)) {
+      *resource = item;
+      return true;
+    }
+  }
+  return false;
+}
+
+}  // namespace cpu_monitor
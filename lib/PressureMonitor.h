@@ -0,0 +1,107 @@
+#pragma once
+
+#include <cstdint>
+#include <string>
+
+#include "detail/noncopyable.hpp"
+
+#ifdef __linux__
+#include "detail/proc_file.h"
+#endif
+
+namespace cpu_monitor {
+
+/**
+ * Pressure stall information: the share of time tasks were stalled waiting for a resource
+ * linux: /proc/pressure/<resource> of the system, or <resource>.pressure of a cgroup v2, needs CONFIG_PSI
+ * other platforms: not supported, sample() returns false
+ */
+class PressureMonitor : detail::noncopyable {
+ public:
+  enum class Resource {
+    CPU,
+    MEMORY,
+    IO,
+  };
+
+  struct Stall {
+    // percent of the time, moving averages over 10s, 60s and 300s
+    float avg10;
+    float avg60;
+    float avg300;
+    uint64_t totalUsec;
+  };
+
+  struct Sample {
+    Stall some;  // at least one task was stalled
+    Stall full;  // all non-idle tasks were stalled at once, always 0 for the cpu of the system before linux 5.13
+  };
+
+ public:
+  /**
+   * @return "cpu", "memory" or "io"
+   */
+  static const char *name(Resource resource);
+
+  /**
+   * @return false if the name is unknown
+   */
+  static bool parse(const std::string &name, Resource *resource);
+
+ public:
+  /**
+   * @param cgroup empty for the system, otherwise a cgroup v2 path like CgroupMonitor
+   */
+  explicit PressureMonitor(Resource resource, const std::string &cgroup = {});
+
+  /**
+   * @return false if not supported or the cgroup has been removed
+   */
+  bool sample(Sample *sample);
+
+ public:
+  const Resource resource;
+  const std::string cgroup;
+
+#ifdef __linux__
+ private:
+  detail::ProcFile file_;
+#endif
+};
+
+/**
+ * Notified by the kernel as soon as the stall time within a window goes over a threshold, instead of polling
+ * the fd is polled for POLLPRI, at most one event is generated per window
+ * other platforms: not supported, open() returns false
+ */
+class PressureTrigger : detail::noncopyable {
+ public:
+  ~PressureTrigger();
+
+  /**
+   * @param cgroup like PressureMonitor
+   * @param full false: some
+   * @param stallUs threshold of the stall time within the window
+   * @param windowUs 500ms to 10s, unprivileged processes need a multiple of 2s
+   * @return false if not supported, not permitted or invalid, errno is set
+   */
+  bool open(PressureMonitor::Resource resource, const std::string &cgroup, bool full, uint32_t stallUs, uint32_t windowUs);
+
+  /**
+   * readiness is POLLPRI, not readable
+   */
+  int fd() const {
+    return fd_;
+  }
+
+  /**
+   * check the fd without blocking, for a wakeup that may be an error
+   * @return false if the trigger is gone, e.g. the cgroup has been removed
+   */
+  bool alive() const;
+
+ private:
+  int fd_ = -1;
+};
+
+}  // namespace cpu_monitor
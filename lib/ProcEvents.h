@@ -0,0 +1,57 @@
+#pragma once
+
+#include <cstdint>
+#include <vector>
+
+#include "Types.h"
+#include "detail/noncopyable.hpp"
+
+namespace cpu_monitor {
+
+struct ProcEvent {
+  enum class Type {
+    FORK,  // a process or a thread is created
+    EXEC,
+    EXIT,  // a process or a thread exits
+  };
+
+  Type type;
+  PID_t pid;             // process (thread group) of the task
+  TaskId_t tid;          // the task, for FORK the new one
+  int exitCode;          // EXIT only, wait status
+  uint64_t timestampNs;  // steady clock
+};
+
+/**
+ * Process lifecycle events of the whole system, pushed by the kernel instead of polling /proc
+ * linux: the netlink proc connector (CN_PROC), may need CAP_NET_ADMIN
+ * other platforms: not supported, open() returns false
+ */
+class ProcEvents : detail::noncopyable {
+ public:
+  ~ProcEvents();
+
+  /**
+   * @return false if not supported or not permitted, errno is set
+   */
+  bool open();
+
+  /**
+   * non-blocking fd, readable when events are pending
+   */
+  int fd() const {
+    return fd_;
+  }
+
+  /**
+   * read all pending events without blocking, appended to `events`
+   * @return false if the kernel has dropped events (ENOBUFS), state built from events must be resynced by polling
+   */
+  bool read(std::vector<ProcEvent> &events);
+
+ private:
+  int fd_ = -1;
+  alignas(8) char buf_[4096];
+};
+
+}  // namespace cpu_monitor
@@ -0,0 +1,261 @@
+#include "ProcessIndex.h"
+
+#include <algorithm>
+#include <regex>
+#include <unordered_set>
+
+#include "ProcEvents.h"
+#include "detail/log.h"
+
+namespace cpu_monitor {
+
+namespace {
+
+using Index = std::unordered_multimap<std::string, PID_t>;
+
+void indexRemove(Index &index, const std::string &key, PID_t pid) {
+  auto range = index.equal_range(key);
+  for (auto iter = range.first; iter != range.second; ++iter) {
+    if (iter->second == pid) {
+      index.erase(iter);
+      return;
+    }
+  }
+}
+
+void indexFind(const Index &index, const std::string &key, std::vector<PID_t> &pids) {
+  auto range = index.equal_range(key);
+  for (auto iter = range.first; iter != range.second; ++iter) {
+    pids.push_back(iter->second);
+  }
+}
+
+// std::regex is slow, patterns without special characters are searched as plain strings
+bool isLiteral(const std::string &pattern) {
+  return pattern.find_first_of("\\^$.|?*+()[]{}") == std::string::npos;
+}
+
+bool startsWith(const std::string &str, const char *prefix, size_t len) {
+  return str.compare(0, len, prefix) == 0;
+}
+
+}  // namespace
+
+ProcessIndex::Query ProcessIndex::Query::parse(const std::string &query) {
+  static const struct {
+    const char *prefix;
+    size_t len;
+    Field field;
+  } Prefixes[] = {
+      {"comm:", 5, Field::COMM},
+      {"exe:", 4, Field::EXE},
+      {"cmdline:", 8, Field::CMDLINE},
+  };
+  for (const auto &item : Prefixes) {
+    if (startsWith(query, item.prefix, item.len)) {
+      return Query{item.field, query.substr(item.len)};
+    }
+  }
+  return Query{Field::COMM, query};
+}
+
+ProcessIndex::Matcher::Matcher(Query query) : query_(std::move(query)) {
+  switch (query_.field) {
+    case Field::COMM:
+      comm_ = query_.pattern.substr(0, CommMaxLen);
+      break;
+    case Field::EXE:
+      break;
+    case Field::CMDLINE:
+      literal_ = isLiteral(query_.pattern);
+      if (literal_) break;
+      try {
+        re_.assign(query_.pattern, std::regex::ECMAScript | std::regex::optimize);
+      } catch (const std::regex_error &e) {
+        cpu_monitor_LOGW("invalid regex: %s: %s", query_.pattern.c_str(), e.what());
+        valid_ = false;
+      }
+      break;
+  }
+}
+
+bool ProcessIndex::Matcher::matchCmdline(const std::string &cmdline) const {
+  if (!valid_ || cmdline.empty()) return false;
+  return literal_ ? cmdline.find(query_.pattern) != std::string::npos : std::regex_search(cmdline, re_);
+}
+
+bool ProcessIndex::update(bool list) {
+  if (list || !listed_) {
+    if (!listPids(pids_)) return false;
+    listed_ = true;
+
+    ++generation_;
+    for (auto pid : pids_) {
+      auto iter = entries_.find(pid);
+      if (iter == entries_.cend()) iter = insert(pid);
+      iter->second.generation = generation_;
+    }
+    for (auto iter = entries_.begin(); iter != entries_.end();) {
+      if (iter->second.generation == generation_) {
+        ++iter;
+        continue;
+      }
+      unindex(iter);
+      iter = entries_.erase(iter);
+    }
+  }
+
+  updated_.clear();
+  for (auto pid : stale_) {
+    auto iter = entries_.find(pid);
+    // exited, or read already by a duplicate
+    if (iter == entries_.cend() || !iter->second.stale) continue;
+    unindex(iter);
+    auto &entry = iter->second;
+    if (!readEntry(pid, &entry)) {
+      entries_.erase(iter);
+      continue;
+    }
+    entry.stale = false;
+    entry.indexed = true;
+    byComm_.emplace(entry.comm, pid);
+    if (!entry.exe.empty()) byExe_.emplace(entry.exe, pid);
+    updated_.push_back(pid);
+  }
+  stale_.clear();
+  return true;
+}
+
+void ProcessIndex::onEvent(const ProcEvent &event) {
+  // only the thread group leaders are processes
+  switch (event.type) {
+    case ProcEvent::Type::FORK:
+      if ((TaskId_t)event.pid != event.tid) return;
+      // the pid may be reused before the exit of the previous one is seen
+      erase(event.pid);
+      insert(event.pid)->second.generation = generation_;
+      break;
+    case ProcEvent::Type::EXEC: {
+      // a non leader thread that execs takes over the pid of the leader
+      auto iter = entries_.find(event.pid);
+      if (iter != entries_.cend()) markStale(iter);
+    } break;
+    case ProcEvent::Type::EXIT:
+      if ((TaskId_t)event.pid != event.tid) return;
+      erase(event.pid);
+      break;
+  }
+}
+
+void ProcessIndex::invalidate() {
+  listed_ = false;
+  for (auto iter = entries_.begin(); iter != entries_.end(); ++iter) {
+    markStale(iter);
+  }
+}
+
+std::vector<PID_t> ProcessIndex::find(const Query &query) const {
+  std::vector<PID_t> pids;
+  switch (query.field) {
+    case Field::COMM:
+      indexFind(byComm_, query.pattern.substr(0, CommMaxLen), pids);
+      break;
+    case Field::EXE:
+      indexFind(byExe_, query.pattern, pids);
+      break;
+    case Field::CMDLINE: {
+      Matcher matcher(query);
+      if (!matcher.valid()) return pids;
+      for (const auto &item : entries_) {
+        if (item.second.indexed && matcher.matchCmdline(item.second.cmdline)) pids.push_back(item.first);
+      }
+    } break;
+  }
+  std::sort(pids.begin(), pids.end());
+  return pids;
+}
+
+std::vector<PID_t> ProcessIndex::find(const Matcher &matcher, const std::vector<PID_t> &pids) const {
+  std::vector<PID_t> ret;
+  if (!matcher.valid()) return ret;
+  const auto &query = matcher.query();
+  for (auto pid : pids) {
+    auto iter = entries_.find(pid);
+    if (iter == entries_.cend() || !iter->second.indexed) continue;
+    const auto &entry = iter->second;
+    bool match;
+    switch (query.field) {
+      case Field::COMM:
+        match = entry.comm == matcher.comm_;
+        break;
+      case Field::EXE:
+        match = entry.exe == query.pattern;
+        break;
+      default:
+        match = matcher.matchCmdline(entry.cmdline);
+        break;
+    }
+    if (match) ret.push_back(pid);
+  }
+  std::sort(ret.begin(), ret.end());
+  return ret;
+}
+
+std::vector<PID_t> ProcessIndex::descendants(const std::vector<PID_t> &pids) const {
+  std::unordered_multimap<PID_t, PID_t> children;
+  for (const auto &item : entries_) {
+    if (item.second.indexed) children.emplace(item.second.ppid, item.first);
+  }
+
+  // a parent may be a reused pid, the tree may have cycles then
+  std::unordered_set<PID_t> visited(pids.cbegin(), pids.cend());
+  std::vector<PID_t> ret;
+  std::vector<PID_t> parents(pids);
+  while (!parents.empty()) {
+    auto pid = parents.back();
+    parents.pop_back();
+    auto range = children.equal_range(pid);
+    for (auto iter = range.first; iter != range.second; ++iter) {
+      if (!visited.insert(iter->second).second) continue;
+      ret.push_back(iter->second);
+      parents.push_back(iter->second);
+    }
+  }
+  std::sort(ret.begin(), ret.end());
+  return ret;
+}
+
+PID_t ProcessIndex::parent(PID_t pid) const {
+  auto iter = entries_.find(pid);
+  if (iter == entries_.cend() || !iter->second.indexed) return 0;
+  return iter->second.ppid;
+}
+
+ProcessIndex::Entries::iterator ProcessIndex::insert(PID_t pid) {
+  auto iter = entries_.emplace(pid, Entry{}).first;
+  stale_.push_back(pid);
+  return iter;
+}
+
+void ProcessIndex::markStale(Entries::iterator iter) {
+  if (iter->second.stale) return;
+  iter->second.stale = true;
+  stale_.push_back(iter->first);
+}
+
+void ProcessIndex::unindex(Entries::iterator iter) {
+  auto &entry = iter->second;
+  if (!entry.indexed) return;
+  entry.indexed = false;
+  indexRemove(byComm_, entry.comm, iter->first);
+  if (!entry.exe.empty()) indexRemove(byExe_, entry.exe, iter->first);
+}
+
+void ProcessIndex::erase(PID_t pid) {
+  auto iter = entries_.find(pid);
+  if (iter == entries_.cend()) return;
+  unindex(iter);
+  entries_.erase(iter);
+}
+
+}  // namespace cpu_monitor
@@ -0,0 +1,159 @@
+#pragma once
+
+#include <cstdint>
+#include <regex>
+#include <string>
+#include <unordered_map>
+#include <vector>
+
+#include "Types.h"
+#include "detail/noncopyable.hpp"
+
+namespace cpu_monitor {
+
+struct ProcEvent;
+
+/**
+ * Names and parents of all processes of the system kept in memory, so looking up a name does not scan /proc
+ * update() only lists the pids, the names of a process are read once when it is new or has exec'd
+ * without ProcEvents fed to onEvent(), a process that execs after it is indexed keeps its old names until invalidate()
+ */
+class ProcessIndex : detail::noncopyable {
+ public:
+  enum class Field {
+    COMM,     // process name, at most CommMaxLen characters, longer patterns are truncated like the kernel does
+    EXE,      // basename of the executable, empty if not permitted to read it or for kernel threads
+    CMDLINE,  // arguments joined by spaces, matched by ECMAScript regex search
+  };
+
+  struct Query {
+    Field field = Field::COMM;
+    std::string pattern;
+
+    /**
+     * "comm:<name>", "exe:<name>", "cmdline:<regex>", otherwise the whole string is a comm
+     */
+    static Query parse(const std::string &query);
+  };
+
+  /**
+   * a query prepared once for matching many processes, e.g. the new ones of every update
+   */
+  class Matcher {
+   public:
+    explicit Matcher(Query query);
+
+    /**
+     * false if the pattern of a CMDLINE query is not a valid regex, nothing matches then
+     */
+    bool valid() const {
+      return valid_;
+    }
+
+    const Query &query() const {
+      return query_;
+    }
+
+   private:
+    friend class ProcessIndex;
+    bool matchCmdline(const std::string &cmdline) const;
+
+   private:
+    Query query_;
+    std::string comm_;  // truncated pattern of a COMM query
+    bool literal_ = true;
+    bool valid_ = true;
+    std::regex re_;
+  };
+
+  static const size_t CommMaxLen;
+
+ public:
+  ProcessIndex();
+  ~ProcessIndex();
+
+  /**
+   * read the names of new and exec'd processes, and drop the exited ones
+   * @param list list all pids, may be false when the index is kept by onEvent() since the last listing
+   * @return false if the processes can not be listed
+   */
+  bool update(bool list = true);
+
+  /**
+   * track process births, execs and exits between updates, the names are read by the next update()
+   */
+  void onEvent(const ProcEvent &event);
+
+  /**
+   * re-read the names of all processes at the next update(), e.g. when ProcEvents lost events
+   */
+  void invalidate();
+
+  /**
+   * @return matching pids in ascending order, empty if none matches or the regex is invalid
+   */
+  std::vector<PID_t> find(const Query &query) const;
+
+  /**
+   * like find(), but only `pids` are matched, e.g. updated()
+   */
+  std::vector<PID_t> find(const Matcher &matcher, const std::vector<PID_t> &pids) const;
+
+  /**
+   * all descendants of `pids` by the parents they were indexed with, `pids` not included
+   * @return pids in ascending order
+   */
+  std::vector<PID_t> descendants(const std::vector<PID_t> &pids) const;
+
+  /**
+   * @return parent pid when the process was indexed, 0 if not indexed
+   */
+  PID_t parent(PID_t pid) const;
+
+  /**
+   * processes whose names are read by the last update(): born, exec'd, or all of them after invalidate()
+   */
+  const std::vector<PID_t> &updated() const {
+    return updated_;
+  }
+
+  size_t size() const {
+    return entries_.size();
+  }
+
+ private:
+  struct Entry {
+    std::string comm;
+    std::string exe;
+    std::string cmdline;
+    PID_t ppid = 0;
+    uint32_t generation = 0;  // of the last listing it is in
+    bool stale = true;        // names are not read yet or outdated
+    bool indexed = false;     // in byComm_ and byExe_
+  };
+  using Entries = std::unordered_map<PID_t, Entry>;
+
+  bool listPids(std::vector<PID_t> &pids);
+  bool readEntry(PID_t pid, Entry *entry);
+
+  Entries::iterator insert(PID_t pid);
+  void markStale(Entries::iterator iter);
+  void unindex(Entries::iterator iter);
+  void erase(PID_t pid);
+
+ private:
+  Entries entries_;
+  std::unordered_multimap<std::string, PID_t> byComm_;
+  std::unordered_multimap<std::string, PID_t> byExe_;
+  std::vector<PID_t> stale_;  // pids to read at the next update
+  std::vector<PID_t> updated_;
+  std::vector<PID_t> pids_;   // listing buffer
+  uint32_t generation_ = 0;
+  bool listed_ = false;
+  std::vector<char> buf_;
+#ifdef __linux__
+  int procFd_ = -1;
+#endif
+};
+
+}  // namespace cpu_monitor
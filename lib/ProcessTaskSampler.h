@@ -0,0 +1,129 @@
+#pragma once
+
+#include <cstdint>
+#include <memory>
+#include <string>
+#include <unordered_map>
+#include <vector>
+
+#include "Types.h"
+#include "detail/noncopyable.hpp"
+
+#ifdef __linux__
+#include "detail/proc_file.h"
+#endif
+
+namespace cpu_monitor {
+
+struct TaskSample {
+  TaskId_t id;
+  char name[64];
+  uint64_t cpuTimeNs;  // cpu time consumed by the thread since it started
+
+  // delay accounting totals, only reported by Backend::TASKSTATS, otherwise 0
+  // cpuDelayNs is also reported by Backend::SCHEDSTAT
+  uint64_t cpuDelayNs;
+  uint64_t blkioDelayNs;
+  uint64_t swapinDelayNs;
+
+  // event counts since the thread started, 0 if not reported by the backend
+  uint64_t minFlt;            // PROCFS, TASKSTATS
+  uint64_t majFlt;            // PROCFS, TASKSTATS
+  uint64_t ctxSwitches;       // voluntary and involuntary, all linux backends
+  uint64_t involCtxSwitches;  // all linux backends
+};
+
+/**
+ * io totals of a process, all threads including the exited ones
+ */
+struct ProcessIo {
+  uint64_t rchar;       // bytes read by read(2) and alike, including the page cache, pipes and sockets
+  uint64_t wchar;       // bytes written by write(2) and alike
+  uint64_t readBytes;   // bytes fetched from the storage
+  uint64_t writeBytes;  // bytes caused to be sent to the storage
+};
+
+#ifdef __linux__
+namespace detail {
+class TaskStatsClient;
+}
+#endif
+
+/**
+ * Sample all threads of a process in one call
+ * linux: /proc/<pid>/task is opened once and listed with getdents64, every <tid>/stat is opened by openat relative to it and kept open
+ */
+class ProcessTaskSampler : detail::noncopyable {
+ public:
+  enum class Backend {
+    PROCFS,     // parse <tid>/stat and the context switches of <tid>/status, cpu time in clock ticks
+    TASKSTATS,  // linux only: query the netlink TASKSTATS family, cpu time in ns and delay accounting
+    SCHEDSTAT,  // linux only: parse <tid>/schedstat and <tid>/status, cpu time and run queue wait in ns
+  };
+
+ public:
+  /**
+   * falls back to Backend::PROCFS if `backend` is not available
+   */
+  explicit ProcessTaskSampler(PID_t pid, Backend backend = Backend::PROCFS);
+  ~ProcessTaskSampler();
+
+  /**
+   * @return false if the process has exited
+   */
+  bool sample();
+
+  /**
+   * sample only `tids` without listing the threads, e.g. when they are tracked by ProcEvents
+   * tids that have exited are skipped
+   * @return false if the process has exited
+   */
+  bool sample(const std::vector<TaskId_t> &tids);
+
+ public:
+  PID_t pid;
+  Backend backend;
+  std::string name;
+  std::vector<TaskSample> samples;
+  uint64_t timestampNs{};  // steady clock time of the last sample
+
+  // read by every sample() along with the threads, false if not permitted (/proc/<pid>/io needs ptrace access)
+  // apple: only readBytes and writeBytes
+  ProcessIo io{};
+  bool ioOk = false;
+
+ private:
+#ifdef __linux__
+  void beginSample();
+  void readIo();
+  bool readTask(const char *tidName);
+  bool readProcfs(const char *tidName, TaskSample *sample);
+  bool readTaskStats(const char *tidName, TaskSample *sample);
+  bool readSchedStat(const char *tidName, TaskSample *sample);
+  struct TaskFile;
+  ssize_t readTaskFile(const char *tidName, const char *fileName, detail::ProcFile TaskFile::*member, char *buf, size_t size);
+  bool readCtxSwitches(const char *tidName, TaskSample *sample);
+  void closeGoneTaskFiles();
+
+ private:
+  int taskDirFd_ = -1;
+  detail::ProcFile ioFile_;
+  std::vector<char> direntBuf_;
+  std::unique_ptr<detail::TaskStatsClient> taskStats_;
+
+  // the files of every thread stay open and are re-read with pread, like TaskMonitor
+  struct TaskFile {
+    detail::ProcFile file;    // <tid>/stat or <tid>/schedstat
+    detail::ProcFile status;  // <tid>/status, not used by Backend::TASKSTATS
+    uint32_t sampleCount;     // of the last sample which listed the thread
+  };
+  std::unordered_map<TaskId_t, TaskFile> taskFiles_;
+
+  // schedstat has no name, names are taken from the previous samples and <tid>/comm is only read for new threads
+  std::vector<TaskSample> prevSamples_;
+  size_t prevCursor_ = 0;
+  uint32_t sampleCount_ = 0;  // of all backends
+#endif
+};
+
+}  // namespace cpu_monitor
@@ -7,8 +7,14 @@
 #include "Types.h"
 #include "detail/noncopyable.hpp"
 
+#ifdef __linux__
+#include "detail/proc_file.h"
+#endif
+
 namespace cpu_monitor {
 
+struct TaskSample;
+
 /**
  * Task means process or thread
  */
@@ -18,8 +24,19 @@ class TaskMonitor : detail::noncopyable {
  public:
   explicit TaskMonitor(TaskId_t tid, TotalTimeImpl cpuTicksImpl);
 
+  /**
+   * create from a sample of ProcessTaskSampler, nothing is read
+   */
+  explicit TaskMonitor(const TaskSample &sample);
+
   bool update();
 
+  /**
+   * update from a sample of ProcessTaskSampler
+   * @param intervalNs wall time since the previous sample
+   */
+  void update(const TaskSample &sample, uint64_t intervalNs);
+
   void dump() const;
 
  public:
@@ -27,9 +44,24 @@ class TaskMonitor : detail::noncopyable {
   TaskId_t id;
   float usage{};
 
+  // delays during the last interval, only reported by ProcessTaskSampler::Backend::TASKSTATS
+  // cpuDelayNs (run queue latency) is also reported by ProcessTaskSampler::Backend::SCHEDSTAT
+  uint64_t cpuDelayNs{};
+  uint64_t blkioDelayNs{};
+  uint64_t swapinDelayNs{};
+
  private:
   TotalTimeImpl totalTimeImpl_;
-  uint64_t totalThreadTime_{};
+  uint64_t totalThreadTime_{};  // ticks, or ns when updated by samples
+  uint64_t totalCpuDelay_{};
+  uint64_t totalBlkioDelay_{};
+  uint64_t totalSwapinDelay_{};
+
+#ifdef __linux__
+  // stat file is kept open, it reports ESRCH once the thread has exited
+  detail::ProcFile statFile_;
+  bool exited_{};
+#endif
 };
 
 }  // namespace cpu_monitor
@@ -0,0 +1,264 @@
+#include "TaskTable.h"
+
+#include <algorithm>
+#include <cstring>
+#include <numeric>
+
+#include "ProcessTaskSampler.h"
+
+namespace cpu_monitor {
+
+void TaskTable::update(std::vector<TaskSample> &samples, uint64_t intervalNs, const BirthCallback &onBirth, const ExitCallback &onExit) {
+  const auto sampleLess = [](const TaskSample &a, const TaskSample &b) {
+    return a.id < b.id;
+  };
+  if (!std::is_sorted(samples.cbegin(), samples.cend(), sampleLess)) {
+    std::sort(samples.begin(), samples.end(), sampleLess);
+  }
+  mergeInserted();
+
+  merged_.clear();
+  merged_.reserve(samples.size());
+  size_t i = 0;
+  auto sample = samples.cbegin();
+  while (i < rows() || sample != samples.cend()) {
+    if (i < rows() && erased(i)) {
+      ++i;
+      continue;
+    }
+    if (sample == samples.cend() || (i < rows() && cols_.ids[i] < sample->id)) {
+      if (onExit) onExit(row(i));
+      ++i;
+      continue;
+    }
+    if (i == rows() || sample->id < cols_.ids[i]) {
+      if (onBirth) onBirth(*sample);
+      merged_.pushNew(*sample, names_.intern(sample->name));
+    } else {
+      auto nameId = cols_.nameIds[i];
+      if (names_.get(nameId) != sample->name) nameId = names_.intern(sample->name);
+      merged_.pushUpdated(cols_, i, *sample, nameId);
+      ++i;
+    }
+    ++sample;
+  }
+  cols_.swap(merged_);
+  sortedRows_ = rows();
+
+  calcUsage(intervalNs);
+  compactNames();
+}
+
+bool TaskTable::insert(const TaskSample &sample) {
+  if (find(sample.id) != NotFound) return false;
+  cols_.pushNew(sample, names_.intern(sample.name));
+  return true;
+}
+
+void TaskTable::erase(TaskId_t tid) {
+  auto i = find(tid);
+  if (i != NotFound) cols_.erased[i] = 1;
+}
+
+size_t TaskTable::find(TaskId_t tid) const {
+  const auto &ids = cols_.ids;
+  auto sortedEnd = ids.cbegin() + (ptrdiff_t)sortedRows_;
+  auto iter = std::lower_bound(ids.cbegin(), sortedEnd, tid);
+  // an erased row may be followed by a reused tid
+  for (; iter != sortedEnd && *iter == tid; ++iter) {
+    auto i = (size_t)(iter - ids.cbegin());
+    if (!erased(i)) return i;
+  }
+  for (auto i = sortedRows_; i < rows(); ++i) {
+    if (ids[i] == tid && !erased(i)) return i;
+  }
+  return NotFound;
+}
+
+void TaskTable::mergeInserted() {
+  if (sortedRows_ == rows()) return;
+
+  // inserted rows are few, sort only their indexes
+  std::vector<size_t> inserted(rows() - sortedRows_);
+  std::iota(inserted.begin(), inserted.end(), sortedRows_);
+  std::sort(inserted.begin(), inserted.end(), [this](size_t a, size_t b) {
+    return cols_.ids[a] < cols_.ids[b];
+  });
+
+  merged_.clear();
+  merged_.reserve(rows());
+  size_t i = 0;
+  auto j = inserted.cbegin();
+  while (i < sortedRows_ || j != inserted.cend()) {
+    if (j == inserted.cend() || (i < sortedRows_ && cols_.ids[i] < cols_.ids[*j])) {
+      merged_.pushRow(cols_, i++);
+    } else {
+      merged_.pushRow(cols_, *j++);
+    }
+  }
+  cols_.swap(merged_);
+  sortedRows_ = rows();
+}
+
+void TaskTable::calcUsage(uint64_t intervalNs) {
+  // plain arrays and no branches: vectorized where int64 to float conversion is (arm64, AVX-512)
+  const auto size = rows();
+  const auto prev = cols_.prevNs.data();
+  const auto cur = cols_.curNs.data();
+  const auto usage = cols_.usage.data();
+  const float scale = intervalNs ? 100.f / (float)intervalNs : 0;
+  for (size_t i = 0; i < size; ++i) {
+    float value = (float)(int64_t)(cur[i] - prev[i]) * scale;
+    usage[i] = value > 100 || value < 0 ? 0 : value;  // invalid data
+  }
+}
+
+void TaskTable::compactNames() {
+  // thread names like `worker-123` never repeat, drop the unused ones once they pile up
+  if (names_.size() < 2 * rows() + 1024) return;
+  detail::StringPool names;
+  for (auto &nameId : cols_.nameIds) {
+    nameId = names.intern(names_.get(nameId).c_str());
+  }
+  std::swap(names_, names);
+}
+
+void TaskTable::Columns::clear() {
+  ids.clear();
+  nameIds.clear();
+  erased.clear();
+  prevNs.clear();
+  curNs.clear();
+  usage.clear();
+  prevCpuDelay.clear();
+  curCpuDelay.clear();
+  prevBlkioDelay.clear();
+  curBlkioDelay.clear();
+  prevSwapinDelay.clear();
+  curSwapinDelay.clear();
+  prevMinFlt.clear();
+  curMinFlt.clear();
+  prevMajFlt.clear();
+  curMajFlt.clear();
+  prevCtxSwitches.clear();
+  curCtxSwitches.clear();
+  prevInvolCtxSwitches.clear();
+  curInvolCtxSwitches.clear();
+}
+
+void TaskTable::Columns::reserve(size_t size) {
+  ids.reserve(size);
+  nameIds.reserve(size);
+  erased.reserve(size);
+  prevNs.reserve(size);
+  curNs.reserve(size);
+  usage.reserve(size);
+  prevCpuDelay.reserve(size);
+  curCpuDelay.reserve(size);
+  prevBlkioDelay.reserve(size);
+  curBlkioDelay.reserve(size);
+  prevSwapinDelay.reserve(size);
+  curSwapinDelay.reserve(size);
+  prevMinFlt.reserve(size);
+  curMinFlt.reserve(size);
+  prevMajFlt.reserve(size);
+  curMajFlt.reserve(size);
+  prevCtxSwitches.reserve(size);
+  curCtxSwitches.reserve(size);
+  prevInvolCtxSwitches.reserve(size);
+  curInvolCtxSwitches.reserve(size);
+}
+
+void TaskTable::Columns::swap(Columns &other) {
+  ids.swap(other.ids);
+  nameIds.swap(other.nameIds);
+  erased.swap(other.erased);
+  prevNs.swap(other.prevNs);
+  curNs.swap(other.curNs);
+  usage.swap(other.usage);
+  prevCpuDelay.swap(other.prevCpuDelay);
+  curCpuDelay.swap(other.curCpuDelay);
+  prevBlkioDelay.swap(other.prevBlkioDelay);
+  curBlkioDelay.swap(other.curBlkioDelay);
+  prevSwapinDelay.swap(other.prevSwapinDelay);
+  curSwapinDelay.swap(other.curSwapinDelay);
+  prevMinFlt.swap(other.prevMinFlt);
+  curMinFlt.swap(other.curMinFlt);
+  prevMajFlt.swap(other.prevMajFlt);
+  curMajFlt.swap(other.curMajFlt);
+  prevCtxSwitches.swap(other.prevCtxSwitches);
+  curCtxSwitches.swap(other.curCtxSwitches);
+  prevInvolCtxSwitches.swap(other.prevInvolCtxSwitches);
+  curInvolCtxSwitches.swap(other.curInvolCtxSwitches);
+}
+
+void TaskTable::Columns::pushNew(const TaskSample &sample, uint32_t nameId) {
+  ids.push_back(sample.id);
+  nameIds.push_back(nameId);
+  erased.push_back(0);
+  prevNs.push_back(sample.cpuTimeNs);
+  curNs.push_back(sample.cpuTimeNs);
+  usage.push_back(0);
+  prevCpuDelay.push_back(sample.cpuDelayNs);
+  curCpuDelay.push_back(sample.cpuDelayNs);
+  prevBlkioDelay.push_back(sample.blkioDelayNs);
+  curBlkioDelay.push_back(sample.blkioDelayNs);
+  prevSwapinDelay.push_back(sample.swapinDelayNs);
+  curSwapinDelay.push_back(sample.swapinDelayNs);
+  prevMinFlt.push_back(sample.minFlt);
+  curMinFlt.push_back(sample.minFlt);
+  prevMajFlt.push_back(sample.majFlt);
+  curMajFlt.push_back(sample.majFlt);
+  prevCtxSwitches.push_back(sample.ctxSwitches);
+  curCtxSwitches.push_back(sample.ctxSwitches);
+  prevInvolCtxSwitches.push_back(sample.involCtxSwitches);
+  curInvolCtxSwitches.push_back(sample.involCtxSwitches);
+}
+
+void TaskTable::Columns::pushRow(const Columns &from, size_t i) {
+  ids.push_back(from.ids[i]);
+  nameIds.push_back(from.nameIds[i]);
+  erased.push_back(from.erased[i]);
+  prevNs.push_back(from.prevNs[i]);
+  curNs.push_back(from.curNs[i]);
+  usage.push_back(from.usage[i]);
+  prevCpuDelay.push_back(from.prevCpuDelay[i]);
+  curCpuDelay.push_back(from.curCpuDelay[i]);
+  prevBlkioDelay.push_back(from.prevBlkioDelay[i]);
+  curBlkioDelay.push_back(from.curBlkioDelay[i]);
+  prevSwapinDelay.push_back(from.prevSwapinDelay[i]);
+  curSwapinDelay.push_back(from.curSwapinDelay[i]);
+  prevMinFlt.push_back(from.prevMinFlt[i]);
+  curMinFlt.push_back(from.curMinFlt[i]);
+  prevMajFlt.push_back(from.prevMajFlt[i]);
+  curMajFlt.push_back(from.curMajFlt[i]);
+  prevCtxSwitches.push_back(from.prevCtxSwitches[i]);
+  curCtxSwitches.push_back(from.curCtxSwitches[i]);
+  prevInvolCtxSwitches.push_back(from.prevInvolCtxSwitches[i]);
+  curInvolCtxSwitches.push_back(from.curInvolCtxSwitches[i]);
+}
+
+void TaskTable::Columns::pushUpdated(const Columns &from, size_t i, const TaskSample &sample, uint32_t nameId) {
+  ids.push_back(sample.id);
+  nameIds.push_back(nameId);
+  erased.push_back(0);
+  prevNs.push_back(from.curNs[i]);
+  curNs.push_back(sample.cpuTimeNs);
+  usage.push_back(0);  // calculated for all rows later
+  prevCpuDelay.push_back(from.curCpuDelay[i]);
+  curCpuDelay.push_back(sample.cpuDelayNs);
+  prevBlkioDelay.push_back(from.curBlkioDelay[i]);
+  curBlkioDelay.push_back(sample.blkioDelayNs);
+  prevSwapinDelay.push_back(from.curSwapinDelay[i]);
+  curSwapinDelay.push_back(sample.swapinDelayNs);
+  prevMinFlt.push_back(from.curMinFlt[i]);
+  curMinFlt.push_back(sample.minFlt);
+  prevMajFlt.push_back(from.curMajFlt[i]);
+  curMajFlt.push_back(sample.majFlt);
+  prevCtxSwitches.push_back(from.curCtxSwitches[i]);
+  curCtxSwitches.push_back(sample.ctxSwitches);
+  prevInvolCtxSwitches.push_back(from.curInvolCtxSwitches[i]);
+  curInvolCtxSwitches.push_back(sample.involCtxSwitches);
+}
+
+}  // namespace cpu_monitor
@@ -0,0 +1,143 @@
+#pragma once
+
+#include <cstdint>
+#include <functional>
+#include <string>
+#include <vector>
+
+#include "Types.h"
+#include "detail/noncopyable.hpp"
+#include "detail/string_pool.h"
+
+namespace cpu_monitor {
+
+struct TaskSample;
+
+/**
+ * Threads updated from the samples of ProcessTaskSampler, stored as parallel arrays instead of a TaskMonitor per thread
+ * rows are kept sorted by id: a new sample is diffed in one linear merge, then usage of all rows is calculated in one loop
+ */
+class TaskTable : detail::noncopyable {
+ public:
+  static const size_t NotFound = SIZE_MAX;
+
+  struct Row {
+    TaskId_t id;
+    const std::string &name;
+    float usage;
+
+    // delays during the last interval, see TaskMonitor
+    uint64_t cpuDelayNs;
+    uint64_t blkioDelayNs;
+    uint64_t swapinDelayNs;
+
+    // events during the last interval, see TaskSample
+    uint64_t minFlt;
+    uint64_t majFlt;
+    uint64_t ctxSwitches;
+    uint64_t involCtxSwitches;
+  };
+
+  using BirthCallback = std::function<void(const TaskSample &sample)>;
+  using ExitCallback = std::function<void(const Row &row)>;
+
+ public:
+  /**
+   * update existing rows, add new ones and remove the ones not in `samples`
+   * @param samples sorted by id in place if needed, getdents64 usually lists them in order already
+   * @param intervalNs wall time since the previous sample
+   */
+  void update(std::vector<TaskSample> &samples, uint64_t intervalNs, const BirthCallback &onBirth = nullptr, const ExitCallback &onExit = nullptr);
+
+  /**
+   * add a row between two updates, e.g. from a ProcEvents fork
+   * @return false if it exists already
+   */
+  bool insert(const TaskSample &sample);
+
+  /**
+   * remove a row between two updates, e.g. from a ProcEvents exit
+   */
+  void erase(TaskId_t tid);
+
+  /**
+   * binary search, rows inserted since the last update are searched linearly
+   * @return row index or NotFound
+   */
+  size_t find(TaskId_t tid) const;
+
+  /**
+   * number of rows including erased ones, use with row()
+   */
+  size_t rows() const {
+    return cols_.ids.size();
+  }
+
+  bool erased(size_t i) const {
+    return cols_.erased[i] != 0;
+  }
+
+  Row row(size_t i) const {
+    return Row{cols_.ids[i],
+               names_.get(cols_.nameIds[i]),
+               cols_.usage[i],
+               delta(cols_.curCpuDelay[i], cols_.prevCpuDelay[i]),
+               delta(cols_.curBlkioDelay[i], cols_.prevBlkioDelay[i]),
+               delta(cols_.curSwapinDelay[i], cols_.prevSwapinDelay[i]),
+               delta(cols_.curMinFlt[i], cols_.prevMinFlt[i]),
+               delta(cols_.curMajFlt[i], cols_.prevMajFlt[i]),
+               delta(cols_.curCtxSwitches[i], cols_.prevCtxSwitches[i]),
+               delta(cols_.curInvolCtxSwitches[i], cols_.prevInvolCtxSwitches[i])};
+  }
+
+  /**
+   * in id order, rows inserted since the last update come last
+   */
+  template <typename Func>
+  void forEach(Func &&func) const {
+    for (size_t i = 0; i < rows(); ++i) {
+      if (!erased(i)) func(row(i));
+    }
+  }
+
+ private:
+  // a tid reused within one interval counts from 0 again, all of `cur` is from the new thread
+  static uint64_t delta(uint64_t cur, uint64_t prev) {
+    return cur >= prev ? cur - prev : cur;
+  }
+
+  struct Columns {
+    std::vector<TaskId_t> ids;
+    std::vector<uint32_t> nameIds;
+    std::vector<uint8_t> erased;
+    std::vector<uint64_t> prevNs;
+    std::vector<uint64_t> curNs;
+    std::vector<float> usage;
+    std::vector<uint64_t> prevCpuDelay, curCpuDelay;
+    std::vector<uint64_t> prevBlkioDelay, curBlkioDelay;
+    std::vector<uint64_t> prevSwapinDelay, curSwapinDelay;
+    std::vector<uint64_t> prevMinFlt, curMinFlt;
+    std::vector<uint64_t> prevMajFlt, curMajFlt;
+    std::vector<uint64_t> prevCtxSwitches, curCtxSwitches;
+    std::vector<uint64_t> prevInvolCtxSwitches, curInvolCtxSwitches;
+
+    void clear();
+    void reserve(size_t size);
+    void swap(Columns &other);
+    void pushNew(const TaskSample &sample, uint32_t nameId);
+    void pushRow(const Columns &from, size_t i);
+    void pushUpdated(const Columns &from, size_t i, const TaskSample &sample, uint32_t nameId);
+  };
+
+  void mergeInserted();
+  void calcUsage(uint64_t intervalNs);
+  void compactNames();
+
+ private:
+  Columns cols_;
+  Columns merged_;  // merge buffer, swapped with cols_
+  size_t sortedRows_ = 0;  // rows after this are inserted since the last update
+  detail::StringPool names_;
+};
+
+}  // namespace cpu_monitor
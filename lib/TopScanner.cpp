@@ -0,0 +1,146 @@
+#include "TopScanner.h"
+
+#include <algorithm>
+#include <chrono>
+#include <cstring>
+
+namespace cpu_monitor {
+
+namespace {
+
+template <typename Candidates>
+void keepTop(Candidates &candidates, size_t topN) {
+  auto n = std::min(topN, candidates.size());
+  std::partial_sort(candidates.begin(), candidates.begin() + n, candidates.end(), [](const auto &a, const auto &b) {
+    return a.key > b.key;
+  });
+  candidates.resize(n);
+}
+
+}  // namespace
+
+bool TopScanner::scan() {
+  auto nowNs = (uint64_t)std::chrono::duration_cast<std::chrono::nanoseconds>(std::chrono::steady_clock::now().time_since_epoch()).count();
+  if (!listProcesses(records_)) return false;
+  intervalNs = timestampNs_ ? nowNs - timestampNs_ : 0;
+  timestampNs_ = nowNs;
+  const float scale = intervalNs ? 100.f / (float)intervalNs : 0;
+
+  ++generation_;
+  processes = records_.size();
+  threads = 0;
+  threadsRead = 0;
+  usages_.assign(records_.size(), 0);
+  threadRecords_.clear();
+  threadCandidates_.clear();
+  for (size_t i = 0; i < records_.size(); ++i) {
+    const auto &record = records_[i];
+    threads += record.threads;
+    auto &entry = entries_[record.pid];
+    bool known = entry.generation != 0 && entry.startTime == record.startTime;
+    auto deltaNs = known && record.cpuTimeNs > entry.cpuTimeNs ? record.cpuTimeNs - entry.cpuTimeNs : 0;
+    if (!known) {
+      entry.startTime = record.startTime;
+      entry.threadsKnown = false;
+      entry.threads.clear();
+    }
+    entry.cpuTimeNs = record.cpuTimeNs;
+    entry.generation = generation_;
+    if (deltaNs == 0) continue;
+    usages_[i] = (float)deltaNs * scale;
+    scanThreads(record, entry, deltaNs, scale);
+  }
+
+  for (auto iter = entries_.begin(); iter != entries_.end();) {
+    if (iter->second.generation != generation_) {
+      iter = entries_.erase(iter);
+    } else {
+      ++iter;
+    }
+  }
+
+  selectTop();
+  return true;
+}
+
+void TopScanner::scanThreads(const ProcessRecord &record, Entry &entry, uint64_t deltaNs, float scale) {
+  if (record.threads <= 1) {
+    // the only thread is the process itself, not read again
+    entry.threadsKnown = false;
+    entry.threads.clear();
+    threadRecords_.emplace_back();
+    auto &thread = threadRecords_.back();
+    thread.pid = record.pid;
+    thread.tid = record.pid;
+    thread.cpuTimeNs = record.cpuTimeNs;
+    memcpy(thread.name, record.name, sizeof(thread.name));
+    threadCandidates_.push_back({std::min((float)deltaNs * scale, 100.f), threadRecords_.size() - 1});
+    return;
+  }
+
+  auto begin = threadRecords_.size();
+  if (!listThreads(record.pid, threadRecords_)) {
+    threadRecords_.resize(begin);
+    return;
+  }
+  threadsRead += threadRecords_.size() - begin;
+  for (size_t i = begin; i < threadRecords_.size(); ++i) {
+    auto &thread = threadRecords_[i];
+    thread.pid = record.pid;
+    auto iter = entry.threads.find(thread.tid);
+    uint64_t threadDeltaNs;
+    if (iter == entry.threads.cend()) {
+      // born since the threads were read last time, all of its time is in the interval
+      threadDeltaNs = entry.threadsKnown ? thread.cpuTimeNs : 0;
+      entry.threads.emplace(thread.tid, ThreadEntry{thread.cpuTimeNs, generation_});
+    } else {
+      threadDeltaNs = thread.cpuTimeNs > iter->second.cpuTimeNs ? thread.cpuTimeNs - iter->second.cpuTimeNs : 0;
+      iter->second = ThreadEntry{thread.cpuTimeNs, generation_};
+    }
+    if (threadDeltaNs) threadCandidates_.push_back({std::min((float)threadDeltaNs * scale, 100.f), i});
+  }
+  for (auto iter = entry.threads.begin(); iter != entry.threads.end();) {
+    if (iter->second.generation != generation_) {
+      iter = entry.threads.erase(iter);
+    } else {
+      ++iter;
+    }
+  }
+  entry.threadsKnown = true;
+}
+
+void TopScanner::selectTop() {
+  auto makeProcess = [this](const Candidate &candidate) {
+    const auto &record = records_[candidate.index];
+    return Process{record.pid, record.name, usages_[candidate.index], record.rss, record.threads};
+  };
+
+  candidates_.clear();
+  for (size_t i = 0; i < records_.size(); ++i) {
+    if (usages_[i] > 0) candidates_.push_back({usages_[i], i});
+  }
+  keepTop(candidates_, topN);
+  topCpu.clear();
+  for (const auto &candidate : candidates_) {
+    topCpu.push_back(makeProcess(candidate));
+  }
+
+  candidates_.clear();
+  for (size_t i = 0; i < records_.size(); ++i) {
+    candidates_.push_back({(float)records_[i].rss, i});
+  }
+  keepTop(candidates_, topN);
+  topRss.clear();
+  for (const auto &candidate : candidates_) {
+    topRss.push_back(makeProcess(candidate));
+  }
+
+  keepTop(threadCandidates_, topN);
+  topThreads.clear();
+  for (const auto &candidate : threadCandidates_) {
+    const auto &thread = threadRecords_[candidate.index];
+    topThreads.push_back(Thread{thread.pid, thread.tid, thread.name, candidate.key});
+  }
+}
+
+}  // namespace cpu_monitor
@@ -0,0 +1,134 @@
+#pragma once
+
+#include <cstdint>
+#include <string>
+#include <unordered_map>
+#include <vector>
+
+#include "Types.h"
+#include "detail/noncopyable.hpp"
+
+namespace cpu_monitor {
+
+/**
+ * Top processes and threads of the whole system by cpu and memory, for when it is not known which ones to monitor
+ * every process is sampled each scan, the threads only of the multi-threaded processes that used cpu since the previous scan:
+ * if the cpu time of a process has not changed, none of its threads has run
+ * linux: /proc/<pid>/stat and /proc/<pid>/task/<tid>/stat, through the kept /proc fd and a reused getdents64 buffer
+ * apple: proc_pidinfo, the threads of other users need root
+ */
+class TopScanner : detail::noncopyable {
+ public:
+  struct Process {
+    PID_t pid;
+    std::string name;
+    float usage;  // percent of one cpu during the last interval, over 100 for multi-threaded processes
+    uint64_t rss;  // kB
+    uint32_t threads;
+  };
+
+  struct Thread {
+    PID_t pid;
+    TaskId_t tid;
+    std::string name;
+    float usage;  // percent of one cpu during the last interval
+  };
+
+ public:
+  /**
+   * @param topN max number of each top list
+   */
+  explicit TopScanner(size_t topN = 10);
+  ~TopScanner();
+
+  /**
+   * sample all processes and update the top lists
+   * the first scan only takes the baseline, the threads of a process are reported from the second scan it is busy in
+   * @return false if the processes can not be listed
+   */
+  bool scan();
+
+ public:
+  const size_t topN;
+
+  // sorted in descending order
+  std::vector<Process> topCpu;  // used cpu during the last interval only
+  std::vector<Process> topRss;
+  std::vector<Thread> topThreads;  // used cpu during the last interval only
+
+  // of the last scan
+  size_t processes = 0;
+  size_t threads = 0;      // all threads of the system, by the thread counts of the processes
+  size_t threadsRead = 0;  // threads sampled one by one
+  uint64_t intervalNs = 0;
+
+ private:
+  // as read by the platform, names are kept in place to not allocate for every process
+  struct ProcessRecord {
+    PID_t pid;
+    uint64_t startTime;  // tells a reused pid apart
+    uint64_t cpuTimeNs;
+    uint64_t rss;
+    uint32_t threads;
+    char name[64];
+  };
+
+  struct ThreadRecord {
+    PID_t pid;  // filled after listing
+    TaskId_t tid;
+    uint64_t cpuTimeNs;
+    char name[64];
+  };
+
+  struct ThreadEntry {
+    uint64_t cpuTimeNs;
+    uint32_t generation;
+  };
+
+  struct Entry {
+    uint64_t startTime = 0;
+    uint64_t cpuTimeNs = 0;
+    uint32_t generation = 0;
+    bool threadsKnown = false;  // baselines of all threads are taken
+    std::unordered_map<TaskId_t, ThreadEntry> threads;
+  };
+
+  struct Candidate {
+    float key;     // usage or rss
+    size_t index;  // in records_ or threadRecords_
+  };
+
+ private:
+  /**
+   * implemented by the platform
+   */
+  bool listProcesses(std::vector<ProcessRecord> &records);
+
+  /**
+   * implemented by the platform, records are appended
+   * @return false if the process has exited
+   */
+  bool listThreads(PID_t pid, std::vector<ThreadRecord> &records);
+
+  void scanThreads(const ProcessRecord &record, Entry &entry, uint64_t deltaNs, float scale);
+  void selectTop();
+
+ private:
+  std::unordered_map<PID_t, Entry> entries_;
+  uint32_t generation_ = 0;
+  uint64_t timestampNs_ = 0;
+
+  // reused between scans
+  std::vector<ProcessRecord> records_;
+  std::vector<float> usages_;
+  std::vector<ThreadRecord> threadRecords_;
+  std::vector<Candidate> threadCandidates_;
+  std::vector<Candidate> candidates_;
+  std::vector<char> buf_;
+
+#ifdef __linux__
+  int procFd_ = -1;
+#endif
+};
+
+}  // namespace cpu_monitor
@@ -17,6 +17,10 @@ struct TasksRet {
 
 TasksRet getTasksOfPid(PID_t pid);
 
+/**
+ * lowest pid whose comm is `name`, 0 if not found
+ * one-off: the stat of every process is read until a match, keep a ProcessIndex for repeated lookups or exe and cmdline
+ */
 PID_t getPidByName(const std::string& name);
 
 }  // namespace Utils
@@ -0,0 +1,29 @@
+#include "CgroupMonitor.h"
+
+#include <cerrno>
+
+namespace cpu_monitor {
+
+std::string CgroupMonitor::root() {
+  return {};
+}
+
+std::string CgroupMonitor::pathOfPid(PID_t pid) {
+  (void)pid;
+  return {};
+}
+
+std::string CgroupMonitor::dir(const std::string &path) {
+  (void)path;
+  return {};
+}
+
+CgroupMonitor::CgroupMonitor(const std::string &path) : path(path) {}
+
+bool CgroupMonitor::sample(Sample *sample) {
+  *sample = Sample{};
+  errno = ENOTSUP;
+  return false;
+}
+
+}  // namespace cpu_monitor
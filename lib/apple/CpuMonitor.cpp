@@ -13,19 +13,28 @@
 
 namespace cpu_monitor {
 
-CpuMonitor::CpuMonitor() {
+CpuMonitor::CpuMonitor(ReadMode mode) {
+  (void)mode;
   ave = std::make_unique<CpuMonitorCore>();
   ave->name = "cpu";
 
   auto cpuNum = std::thread::hardware_concurrency();
 
   cpu_monitor_LOGI("cpu core: %d", cpuNum);
-  for (int i = 0; i < cpuNum; i++) {
+  resizeCores(cpuNum);
+  update();
+}
+
+void CpuMonitor::resizeCores(size_t num) {
+  while (cores.size() < num) {
     auto monitor = std::make_unique<CpuMonitorCore>();
-    monitor->name = "cpu" + std::to_string(i);
+    monitor->id = (int)cores.size();
+    monitor->name = "cpu" + std::to_string(monitor->id);
+    monitor->online = false;
     cores.push_back(std::move(monitor));
   }
-  update();
+  table_.resize(cores.size() + 1);
+  machTicks_.resize(table_.rows() * CPU_STATE_MAX);
 }
 
 void CpuMonitor::update(bool updateCores) {
@@ -36,9 +45,12 @@ void CpuMonitor::update(bool updateCores) {
     auto kr = host_statistics(mach_host_self(), HOST_CPU_LOAD_INFO, (host_info_t)&load, &count);
     if (kr != KERN_SUCCESS) throw std::runtime_error("host_statistics failed");
 
-    ave->update(load.cpu_ticks);
+    setTicks(0, load.cpu_ticks);
+  }
+  if (!updateCores) {
+    updateViews(1);
+    return;
   }
-  if (!updateCores) return;
 
   // update cores
   {
@@ -52,11 +64,44 @@ void CpuMonitor::update(bool updateCores) {
       vm_deallocate(mach_task_self(), reinterpret_cast<vm_address_t>(cpuInfo), cpuNum * sizeof(processor_cpu_load_info));
     };
 
+    // processors are listed by id, the ones not listed are taken as offline
+    if (cpuNum > cores.size()) resizeCores(cpuNum);
     auto cpuInfoTmp = cpuInfo;
-    for (const auto &item : cores) {
-      item->update((CpuInfoNative *)cpuInfoTmp);
+    for (size_t i = 0; i < cores.size(); ++i) {
+      cores[i]->online = i < cpuNum;
+      if (!cores[i]->online) continue;
+      setTicks(i + 1, (const natural_t *)cpuInfoTmp);
       cpuInfoTmp += CPU_STATE_MAX;
     }
+    updateViews(table_.rows());
+  }
+}
+
+void CpuMonitor::setTicks(size_t row, const natural_t *cpuTicks) {
+  // natural_t counters wrap at 2^32, extend them with the 32-bit delta from the previous ticks
+  auto machTicks = &machTicks_[row * CPU_STATE_MAX];
+  for (int state = 0; state < CPU_STATE_MAX; ++state) {
+    machTicks[state] += (uint32_t)(cpuTicks[state] - (uint32_t)machTicks[state]);
+  }
+
+  uint64_t ticks[CpuT::TYPE_NUM]{};
+  ticks[CpuT::USER] = machTicks[CPU_STATE_USER];
+  ticks[CpuT::NICE] = machTicks[CPU_STATE_NICE];
+  ticks[CpuT::SYSTEM] = machTicks[CPU_STATE_SYSTEM];
+  ticks[CpuT::IDLE] = machTicks[CPU_STATE_IDLE];
+  table_.setTicks(row, ticks);
+}
+
+void CpuMonitor::updateViews(size_t rows) {
+  table_.update(rows);
+  for (size_t row = 0; row < rows; ++row) {
+    auto &view = row == 0 ? *ave : *cores[row - 1];
+    view.usage = table_.usage(row);
+    view.totalTime = table_.totalTime(row);
+    view.idleTime = table_.idleTime(row);
+    for (int type = 0; type < CpuT::TYPE_NUM; ++type) {
+      view.times[type] = table_.time(row, type);
+    }
   }
 }
 
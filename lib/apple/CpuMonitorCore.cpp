@@ -12,18 +12,26 @@ void CpuMonitorCore::update(CpuInfoNative *p) {
   invertAB();
   {
     auto &cpuTick = tickCur();
-    auto cpu_ticks = p;
-    cpuTick.idleTicks = cpu_ticks[CPU_STATE_IDLE];
+    auto &pre = tickPre();
+    // natural_t counters wrap at 2^32, extend them with the 32-bit delta from the previous ticks
+    auto extend = [](uint64_t pre, natural_t cur) -> uint64_t {
+      return pre + (uint32_t)(cur - (uint32_t)pre);
+    };
+    cpuTick.ticks[CpuT::USER] = extend(pre.ticks[CpuT::USER], p[CPU_STATE_USER]);
+    cpuTick.ticks[CpuT::NICE] = extend(pre.ticks[CpuT::NICE], p[CPU_STATE_NICE]);
+    cpuTick.ticks[CpuT::SYSTEM] = extend(pre.ticks[CpuT::SYSTEM], p[CPU_STATE_SYSTEM]);
+    cpuTick.ticks[CpuT::IDLE] = extend(pre.ticks[CpuT::IDLE], p[CPU_STATE_IDLE]);
     cpuTick.totalTicks = 0;
-    for (int i = 0; i < CPU_STATE_MAX; ++i) {
-      cpuTick.totalTicks += cpu_ticks[i];
+    for (auto tick : cpuTick.ticks) {
+      cpuTick.totalTicks += tick;
     }
   }
   calcUsage();
 }
 
 void CpuMonitorCore::dump() const {
-  cpu_monitor_LOGI("%s: usage: %.2f%%", name.c_str(), usage);
+  cpu_monitor_LOGI("%s: usage: %.2f%%, user: %.2f%%, system: %.2f%%, iowait: %.2f%%, softirq: %.2f%%, steal: %.2f%%", name.c_str(), usage,
+                   times[CpuT::USER], times[CpuT::SYSTEM], times[CpuT::IOWAIT], times[CpuT::SOFTIRQ], times[CpuT::STEAL]);
 }
 
 void CpuMonitorCore::invertAB() {
@@ -39,10 +47,23 @@ CpuTick &CpuMonitorCore::tickPre() {
 }
 
 void CpuMonitorCore::calcUsage() {
-  totalTime = tickCur().totalTicks - tickPre().totalTicks;
-  idleTime = tickCur().idleTicks - tickPre().idleTicks;
-  uint64_t active = totalTime - idleTime;
-  usage = active * 100.f / totalTime;  // NOLINT
+  auto &cur = tickCur();
+  auto &pre = tickPre();
+  // start over from the current ticks if the counters restarted
+  bool reset = cur.isResetFrom(pre);
+  uint64_t deltas[CpuT::TYPE_NUM];
+  totalTime = 0;
+  for (int type = 0; type < CpuT::TYPE_NUM; ++type) {
+    deltas[type] = reset ? 0 : calcTickDelta(cur.ticks[type], pre.ticks[type]);
+    totalTime += deltas[type];
+  }
+  idleTime = deltas[CpuT::IDLE] + deltas[CpuT::IOWAIT];
+
+  float scale = totalTime ? 100.f / totalTime : 0;
+  usage = (totalTime - idleTime) * scale;
+  for (int type = 0; type < CpuT::TYPE_NUM; ++type) {
+    times[type] = deltas[type] * scale;
+  }
 }
 
 }  // namespace cpu_monitor
@@ -3,6 +3,7 @@
 #include <libproc.h>
 #include <sys/proc_info.h>
 
+#include <cerrno>
 #include <cinttypes>
 #include <cstdio>
 
@@ -33,4 +34,21 @@ void MemMonitor::dumpUsage(PID_t pid) {
   printf("resident memory size (bytes): %" PRIu64 "\n", info.pti_resident_size);
 }
 
+MemMonitor::MemMonitor(PID_t pid) : pid(pid == 0 ? getpid() : pid) {}
+
+bool MemMonitor::sampleStatm(Statm *statm) {
+  proc_taskinfo info;  // NOLINT
+  if (proc_pidinfo(pid, PROC_PIDTASKINFO, 0, &info, sizeof(info)) != sizeof(info)) return false;
+  *statm = Statm{};
+  statm->VmSize = info.pti_virtual_size / 1024;
+  statm->VmRSS = info.pti_resident_size / 1024;
+  return true;
+}
+
+bool MemMonitor::sampleRollup(Rollup *rollup) {
+  (void)rollup;
+  errno = ENOTSUP;
+  return false;
+}
+
 }  // namespace cpu_monitor
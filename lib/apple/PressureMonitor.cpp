@@ -0,0 +1,31 @@
+#include "PressureMonitor.h"
+
+#include <cerrno>
+
+namespace cpu_monitor {
+
+PressureMonitor::PressureMonitor(Resource resource, const std::string &cgroup) : resource(resource), cgroup(cgroup) {}
+
+bool PressureMonitor::sample(Sample *sample) {
+  *sample = Sample{};
+  errno = ENOTSUP;
+  return false;
+}
+
+PressureTrigger::~PressureTrigger() = default;
+
+bool PressureTrigger::open(PressureMonitor::Resource resource, const std::string &cgroup, bool full, uint32_t stallUs, uint32_t windowUs) {
+  (void)resource;
+  (void)cgroup;
+  (void)full;
+  (void)stallUs;
+  (void)windowUs;
+  errno = ENOTSUP;
+  return false;
+}
+
+bool PressureTrigger::alive() const {
+  return false;
+}
+
+}  // namespace cpu_monitor
@@ -0,0 +1,19 @@
+#include "ProcEvents.h"
+
+#include <cerrno>
+
+namespace cpu_monitor {
+
+ProcEvents::~ProcEvents() = default;
+
+bool ProcEvents::open() {
+  errno = ENOTSUP;
+  return false;
+}
+
+bool ProcEvents::read(std::vector<ProcEvent> &events) {
+  (void)events;
+  return true;
+}
+
+}  // namespace cpu_monitor
@@ -0,0 +1,68 @@
+#include "ProcessIndex.h"
+
+#include <libproc.h>
+#include <sys/sysctl.h>
+
+#include <algorithm>
+#include <cstring>
+
+namespace cpu_monitor {
+
+const size_t ProcessIndex::CommMaxLen = 2 * MAXCOMLEN;
+
+ProcessIndex::ProcessIndex() {
+  buf_.resize(256 * 1024);
+}
+
+ProcessIndex::~ProcessIndex() = default;
+
+bool ProcessIndex::listPids(std::vector<PID_t> &pids) {
+  pids.clear();
+  // bytes needed, the number of processes may grow until the next call
+  int size = proc_listpids(PROC_ALL_PIDS, 0, nullptr, 0);
+  if (size <= 0) return false;
+  pids.resize(size / sizeof(pid_t) + 64);
+  size = proc_listpids(PROC_ALL_PIDS, 0, pids.data(), (int)(pids.size() * sizeof(pid_t)));
+  if (size <= 0) return false;
+  pids.resize(size / sizeof(pid_t));
+  pids.erase(std::remove(pids.begin(), pids.end(), 0), pids.end());
+  return true;
+}
+
+bool ProcessIndex::readEntry(PID_t pid, Entry *entry) {
+  char name[2 * MAXCOMLEN + 1];
+  if (proc_name(pid, name, sizeof(name)) <= 0) return false;
+  entry->comm = name;
+  proc_bsdshortinfo info;  // NOLINT
+  if (proc_pidinfo(pid, PROC_PIDT_SHORTBSDINFO, 0, &info, sizeof(info)) != sizeof(info)) return false;
+  entry->ppid = (PID_t)info.pbsi_ppid;
+
+  char path[PROC_PIDPATHINFO_MAXSIZE];
+  entry->exe.clear();
+  if (proc_pidpath(pid, path, sizeof(path)) > 0) {
+    auto slash = strrchr(path, '/');
+    entry->exe = slash ? slash + 1 : path;
+  }
+
+  // KERN_PROCARGS2: argc, the executable path, then argv, all separated by `\0`
+  entry->cmdline.clear();
+  int mib[3] = {CTL_KERN, KERN_PROCARGS2, pid};
+  size_t size = buf_.size();
+  if (sysctl(mib, 3, buf_.data(), &size, nullptr, 0) != 0 || size < sizeof(int)) return true;
+  int argc;
+  memcpy(&argc, buf_.data(), sizeof(argc));
+  auto p = buf_.data() + sizeof(int);
+  auto end = buf_.data() + size;
+  p = (char *)memchr(p, '\0', end - p);
+  if (p == nullptr) return true;
+  while (p < end && *p == '\0') ++p;
+  for (int i = 0; i < argc && p < end; ++i) {
+    auto len = strnlen(p, end - p);
+    if (!entry->cmdline.empty()) entry->cmdline += ' ';
+    entry->cmdline.append(p, len);
+    p += len + 1;
+  }
+  return true;
+}
+
+}  // namespace cpu_monitor
@@ -0,0 +1,90 @@
+#include "ProcessTaskSampler.h"
+
+#include <libproc.h>
+#include <mach/mach.h>
+#include <pthread.h>
+
+#include <chrono>
+#include <cstdio>
+
+#include "detail/defer.h"
+
+namespace cpu_monitor {
+
+ProcessTaskSampler::ProcessTaskSampler(PID_t pid, Backend backend) : pid(pid), backend(Backend::PROCFS) {
+  (void)backend;
+  char nameTmp[1024];
+  proc_name(pid, nameTmp, sizeof(nameTmp));
+  name = nameTmp;
+}
+
+ProcessTaskSampler::~ProcessTaskSampler() = default;
+
+bool ProcessTaskSampler::sample() {
+  samples.clear();
+  timestampNs = std::chrono::duration_cast<std::chrono::nanoseconds>(std::chrono::steady_clock::now().time_since_epoch()).count();
+
+  rusage_info_v2 rusage;  // NOLINT
+  ioOk = proc_pid_rusage(pid, RUSAGE_INFO_V2, (rusage_info_t *)&rusage) == 0;
+  if (ioOk) {
+    io.rchar = io.wchar = 0;
+    io.readBytes = rusage.ri_diskio_bytesread;
+    io.writeBytes = rusage.ri_diskio_byteswritten;
+  }
+
+  task_t task;
+  kern_return_t kr = task_for_pid(mach_task_self(), pid, &task);
+  if (kr != KERN_SUCCESS) return false;
+  defer {
+    mach_port_deallocate(mach_task_self(), task);
+  };
+
+  thread_act_array_t threads;
+  mach_msg_type_number_t threadCount = 0;
+  kr = task_threads(task, &threads, &threadCount);
+  if (kr != KERN_SUCCESS) return false;
+  // task_threads gives a send right for every thread, and the array is allocated in our address space
+  defer {
+    for (mach_msg_type_number_t i = 0; i < threadCount; ++i) {
+      mach_port_deallocate(mach_task_self(), threads[i]);
+    }
+    vm_deallocate(mach_task_self(), (vm_address_t)threads, sizeof(thread_act_t) * threadCount);
+  };
+
+  for (mach_msg_type_number_t i = 0; i < threadCount; ++i) {
+    thread_basic_info_data_t info;
+    mach_msg_type_number_t count = THREAD_BASIC_INFO_COUNT;
+    kr = thread_info(threads[i], THREAD_BASIC_INFO, (thread_info_t)&info, &count);
+    if (kr != KERN_SUCCESS) continue;
+    // the port names change once the rights are released, the thread id is stable like a linux tid
+    thread_identifier_info_data_t identifier;
+    count = THREAD_IDENTIFIER_INFO_COUNT;
+    kr = thread_info(threads[i], THREAD_IDENTIFIER_INFO, (thread_info_t)&identifier, &count);
+    if (kr != KERN_SUCCESS) continue;
+
+    samples.emplace_back();
+    auto &sample = samples.back();
+    sample.id = (TaskId_t)identifier.thread_id;
+    sample.cpuDelayNs = sample.blkioDelayNs = sample.swapinDelayNs = 0;
+    sample.minFlt = sample.majFlt = sample.ctxSwitches = sample.involCtxSwitches = 0;
+    sample.cpuTimeNs = (uint64_t)(info.user_time.seconds + info.system_time.seconds) * 1000000000ULL +
+                       (uint64_t)(info.user_time.microseconds + info.system_time.microseconds) * 1000ULL;
+    sample.name[0] = '\0';
+    pthread_t pt = pthread_from_mach_thread_np(threads[i]);
+    if (pt) {
+      pthread_getname_np(pt, sample.name, sizeof(sample.name));
+    }
+    if (sample.name[0] == '\0') {
+      snprintf(sample.name, sizeof(sample.name), "%u", sample.id);
+    }
+  }
+  return !samples.empty();
+}
+
+bool ProcessTaskSampler::sample(const std::vector<TaskId_t> &tids) {
+  // thread ids can not be looked up without listing the threads
+  (void)tids;
+  return sample();
+}
+
+}  // namespace cpu_monitor
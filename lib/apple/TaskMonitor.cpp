@@ -7,6 +7,7 @@
 
 #include <iostream>
 
+#include "ProcessTaskSampler.h"
 #include "Utils.h"
 #include "detail/log.h"
 
@@ -16,6 +17,14 @@ TaskMonitor::TaskMonitor(TaskId_t tid, TaskMonitor::TotalTimeImpl cpuTicksImpl)
   (void)totalThreadTime_;
 }
 
+TaskMonitor::TaskMonitor(const TaskSample &sample)
+    : name(sample.name),
+      id(sample.id),
+      totalThreadTime_(sample.cpuTimeNs),
+      totalCpuDelay_(sample.cpuDelayNs),
+      totalBlkioDelay_(sample.blkioDelayNs),
+      totalSwapinDelay_(sample.swapinDelayNs) {}
+
 bool TaskMonitor::update() {
   mach_msg_type_number_t count = THREAD_INFO_MAX;
   thread_basic_info_data_t info;
@@ -42,6 +51,24 @@ bool TaskMonitor::update() {
   return true;
 }
 
+void TaskMonitor::update(const TaskSample &sample, uint64_t intervalNs) {
+  if (name != sample.name) {
+    name = sample.name;
+  }
+  usage = intervalNs ? (sample.cpuTimeNs - totalThreadTime_) * 100.f / intervalNs : 0;  // NOLINT
+  if (usage > 100) {                                                                    // invalid data
+    usage = 0;
+  }
+  totalThreadTime_ = sample.cpuTimeNs;
+
+  cpuDelayNs = sample.cpuDelayNs - totalCpuDelay_;
+  blkioDelayNs = sample.blkioDelayNs - totalBlkioDelay_;
+  swapinDelayNs = sample.swapinDelayNs - totalSwapinDelay_;
+  totalCpuDelay_ = sample.cpuDelayNs;
+  totalBlkioDelay_ = sample.blkioDelayNs;
+  totalSwapinDelay_ = sample.swapinDelayNs;
+}
+
 void TaskMonitor::dump() const {
   // clang-format off
   std::cout << ">> TaskMonitor dump: \n"
@@ -0,0 +1,86 @@
+#include "TopScanner.h"
+
+#include <libproc.h>
+#include <mach/mach_time.h>
+#include <sys/proc_info.h>
+
+#include <cstring>
+
+namespace cpu_monitor {
+
+namespace {
+
+// pti_total_user and pti_total_system are in mach absolute time units
+uint64_t machToNs(uint64_t time) {
+  static mach_timebase_info_data_t timebase = [] {
+    mach_timebase_info_data_t info;  // NOLINT
+    mach_timebase_info(&info);
+    return info;
+  }();
+  return time * timebase.numer / timebase.denom;
+}
+
+void copyName(char *dst, size_t size, const char *src) {
+  strncpy(dst, src, size - 1);
+  dst[size - 1] = '\0';
+}
+
+}  // namespace
+
+TopScanner::TopScanner(size_t topN) : topN(topN) {
+  buf_.resize(64 * 1024);
+}
+
+TopScanner::~TopScanner() = default;
+
+bool TopScanner::listProcesses(std::vector<ProcessRecord> &records) {
+  records.clear();
+  // bytes needed, the number of processes may grow until the next call
+  int size = proc_listpids(PROC_ALL_PIDS, 0, nullptr, 0);
+  if (size <= 0) return false;
+  std::vector<pid_t> pids(size / sizeof(pid_t) + 64);
+  size = proc_listpids(PROC_ALL_PIDS, 0, pids.data(), (int)(pids.size() * sizeof(pid_t)));
+  if (size <= 0) return false;
+  pids.resize(size / sizeof(pid_t));
+
+  for (auto pid : pids) {
+    if (pid == 0) continue;
+    proc_taskallinfo info;  // NOLINT
+    if (proc_pidinfo(pid, PROC_PIDTASKALLINFO, 0, &info, sizeof(info)) != sizeof(info)) continue;
+    records.emplace_back();
+    auto &record = records.back();
+    record.pid = (PID_t)pid;
+    record.startTime = info.pbsd.pbi_start_tvsec * 1000000ULL + info.pbsd.pbi_start_tvusec;
+    record.cpuTimeNs = machToNs(info.ptinfo.pti_total_user + info.ptinfo.pti_total_system);
+    record.rss = info.ptinfo.pti_resident_size / 1024;
+    record.threads = (uint32_t)info.ptinfo.pti_threadnum;
+    copyName(record.name, sizeof(record.name), info.pbsd.pbi_name[0] ? info.pbsd.pbi_name : info.pbsd.pbi_comm);
+  }
+  return true;
+}
+
+bool TopScanner::listThreads(PID_t pid, std::vector<ThreadRecord> &records) {
+  int size;
+  for (;;) {
+    size = proc_pidinfo(pid, PROC_PIDLISTTHREADS, 0, buf_.data(), (int)buf_.size());
+    if (size <= 0) return false;
+    if ((size_t)size < buf_.size()) break;
+    buf_.resize(buf_.size() * 2);
+  }
+
+  auto count = size / sizeof(uint64_t);
+  for (size_t i = 0; i < count; ++i) {
+    uint64_t handle;
+    memcpy(&handle, buf_.data() + i * sizeof(uint64_t), sizeof(handle));
+    proc_threadinfo info;  // NOLINT
+    if (proc_pidinfo(pid, PROC_PIDTHREADINFO, handle, &info, sizeof(info)) != sizeof(info)) continue;
+    records.emplace_back();
+    auto &record = records.back();
+    record.tid = (TaskId_t)handle;
+    record.cpuTimeNs = info.pth_user_time + info.pth_system_time;
+    copyName(record.name, sizeof(record.name), info.pth_name);
+  }
+  return true;
+}
+
+}  // namespace cpu_monitor
@@ -6,6 +6,7 @@
 
 #include <string>
 
+#include "ProcessIndex.h"
 #include "detail/defer.h"
 
 namespace cpu_monitor {
@@ -47,20 +48,10 @@ TasksRet getTasksOfPid(PID_t pid) {
 }
 
 PID_t getPidByName(const std::string& name) {
-  int precessNum = proc_listpids(PROC_ALL_PIDS, 0, nullptr, 0);
-  pid_t pids[precessNum];
-  proc_listpids(PROC_ALL_PIDS, 0, pids, precessNum);
-  for (int i = 0; i < precessNum; ++i) {
-    if (pids[i] == 0) {
-      continue;
-    }
-    char name_tmp[1024];
-    proc_name(pids[i], name_tmp, sizeof(name_tmp));
-    if (name == name_tmp) {
-      return pids[i];
-    }
-  }
-  return 0;
+  ProcessIndex index;
+  if (!index.update()) return 0;
+  auto pids = index.find(ProcessIndex::Query{ProcessIndex::Field::COMM, name});
+  return pids.empty() ? 0 : pids.front();
 }
 
 }  // namespace Utils
@@ -0,0 +1,113 @@
+#include <cstdio>
+#include <string>
+#include <vector>
+
+#include "CpuMonitor.h"
+#include "CpuTable.h"
+#include "bench_def.h"
+#include "detail/log.h"
+#include "linux/CpuStat.h"
+
+using namespace cpu_monitor;
+
+static std::string makeProcStat(int coreNum) {
+  std::string text;
+  char line[256];
+  auto appendCpu = [&](const char* name, int seed) {
+    snprintf(line, sizeof(line), "%s %d %d %d %d %d %d %d %d %d %d\n", name, 123456 + seed, 789 + seed, 45678 + seed, 98765432 + seed, 3210 + seed,
+             0, 4321 + seed, 12 + seed, 0, 0);
+    text += line;
+  };
+  appendCpu("cpu ", 0);
+  for (int i = 0; i < coreNum; ++i) {
+    appendCpu(("cpu" + std::to_string(i)).c_str(), i);
+  }
+  text += "intr 110109 0 0 0 0 0 0 0 0 0 0 0 0 0 0 0 0 0 0 0 0 0 0 0 0 1 1 2 0 0 0 0 182 11 0 27 1 59907\n";
+  text += "ctxt 256931\nbtime 1700000000\nprocesses 1234\nprocs_running 1\nprocs_blocked 0\n";
+  return text;
+}
+
+static void benchParse(int coreNum) {
+  auto text = makeProcStat(coreNum);
+  std::vector<CpuMonitorCore> cores(coreNum + 1);
+
+  char name[64];
+  snprintf(name, sizeof(name), "fscanf   %4d cores", coreNum);
+  BENCH(name, 2000, [&] {
+    FILE* fp = fmemopen(&text[0], text.size(), "r");
+    for (auto& core : cores) core.update(fp);
+    fclose(fp);
+  });
+
+  snprintf(name, sizeof(name), "parse    %4d cores", coreNum);
+  BENCH(name, 2000, [&] {
+    const char* p = text.data();
+    const char* end = p + text.size();
+    detail::CpuStat stat;  // NOLINT
+    for (auto& core : cores) {
+      p = stat.parse(p, end);
+      core.update(stat);
+    }
+  });
+}
+
+static void benchCalc(int coreNum) {
+  auto text = makeProcStat(coreNum);
+  std::vector<detail::CpuStat> stats(coreNum + 1);
+  const char* p = text.data();
+  const char* end = p + text.size();
+  for (auto& stat : stats) p = stat.parse(p, end);
+
+  // advance the ticks a little each time so that every delta is non-zero
+  auto next = [&] {
+    for (size_t i = 0; i < stats.size(); ++i) {
+      stats[i].ticks[CpuT::USER] += 1 + i % 3;
+      stats[i].ticks[CpuT::IDLE] += 2;
+    }
+  };
+
+  char name[64];
+  std::vector<CpuMonitorCore> cores(coreNum + 1);
+  snprintf(name, sizeof(name), "CpuMonitorCore %4d cores", coreNum);
+  BENCH(name, 20000, [&] {
+    next();
+    for (size_t i = 0; i < cores.size(); ++i) cores[i].update(stats[i]);
+  });
+
+  CpuTable table(coreNum + 1);
+  snprintf(name, sizeof(name), "CpuTable       %4d cores", coreNum);
+  BENCH(name, 20000, [&] {
+    next();
+    for (size_t i = 0; i < stats.size(); ++i) table.setTicks(i, stats[i].ticks);
+    table.update();
+  });
+
+  // the calculation only, without filling the columns
+  snprintf(name, sizeof(name), "CpuTable calc  %4d cores", coreNum);
+  BENCH(name, 20000, [&] {
+    table.update();
+  });
+}
+
+int main() {
+  cpu_monitor_LOGI("=> parse synthetic /proc/stat");
+  for (int coreNum : {8, 64, 256, 1024}) {
+    benchParse(coreNum);
+  }
+
+  cpu_monitor_LOGI("=> calculate usage of parsed ticks");
+  for (int coreNum : {8, 64, 256, 1024}) {
+    benchCalc(coreNum);
+  }
+
+  cpu_monitor_LOGI("=> read /proc/stat");
+  CpuMonitor stdio(CpuMonitor::ReadMode::STDIO);
+  CpuMonitor pread(CpuMonitor::ReadMode::PREAD);
+  BENCH("CpuMonitor::update STDIO", 20000, [&] {
+    stdio.update(true);
+  });
+  BENCH("CpuMonitor::update PREAD", 20000, [&] {
+    pread.update(true);
+  });
+  return 0;
+}
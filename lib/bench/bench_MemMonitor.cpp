@@ -0,0 +1,30 @@
+#include <unistd.h>
+
+#include "MemMonitor.h"
+#include "bench_def.h"
+#include "detail/log.h"
+
+using namespace cpu_monitor;
+
+int main() {
+  cpu_monitor_LOGI("=> read memory usage of self");
+  MemMonitor monitor;
+  BENCH("MemMonitor::getUsage   status", 20000, [] {
+    MemMonitor::getUsage();
+  });
+
+  MemMonitor::Statm statm;  // NOLINT
+  BENCH("MemMonitor::sampleStatm statm", 20000, [&] {
+    monitor.sampleStatm(&statm);
+  });
+
+  MemMonitor::Rollup rollup;  // NOLINT
+  if (!monitor.sampleRollup(&rollup)) {
+    cpu_monitor_LOGW("smaps_rollup not available");
+    return 0;
+  }
+  BENCH("MemMonitor::sampleRollup smaps_rollup", 20000, [&] {
+    monitor.sampleRollup(&rollup);
+  });
+  return 0;
+}
@@ -0,0 +1,40 @@
+#include "ProcessIndex.h"
+#include "Utils.h"
+#include "bench_def.h"
+#include "detail/log.h"
+
+using namespace cpu_monitor;
+
+int main() {
+  ProcessIndex index;
+  index.update();
+  cpu_monitor_LOGI("=> processes: %zu", index.size());
+
+  BENCH("Utils::getPidByName", 20, [] {
+    Utils::getPidByName("init");
+  });
+  BENCH("ProcessIndex::update list", 200, [&] {
+    index.update();
+  });
+  BENCH("ProcessIndex::update kept by events", 20000, [&] {
+    index.update(false);
+  });
+
+  auto comm = ProcessIndex::Query::parse("comm:init");
+  BENCH("ProcessIndex::find comm", 200000, [&] {
+    index.find(comm);
+  });
+  auto exe = ProcessIndex::Query::parse("exe:bash");
+  BENCH("ProcessIndex::find exe", 200000, [&] {
+    index.find(exe);
+  });
+  auto cmdline = ProcessIndex::Query::parse("cmdline:^/usr/bin/.*--daemon");
+  BENCH("ProcessIndex::find cmdline", 2000, [&] {
+    index.find(cmdline);
+  });
+  auto literal = ProcessIndex::Query::parse("cmdline:--daemon");
+  BENCH("ProcessIndex::find cmdline literal", 20000, [&] {
+    index.find(literal);
+  });
+  return 0;
+}
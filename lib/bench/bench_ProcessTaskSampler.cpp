@@ -0,0 +1,46 @@
+#include <unistd.h>
+
+#include <atomic>
+#include <cstdio>
+#include <thread>
+#include <vector>
+
+#include "ProcessTaskSampler.h"
+#include "bench_def.h"
+#include "detail/log.h"
+
+using namespace cpu_monitor;
+
+int main() {
+  std::atomic<bool> stop{false};
+  std::vector<std::thread> threads;
+  for (int i = 0; i < 64; ++i) {
+    threads.emplace_back([&] {
+      while (!stop) usleep(10 * 1000);
+    });
+  }
+
+  cpu_monitor_LOGI("=> sample %zu threads", threads.size() + 1);
+  uint64_t sink = 0;
+  const auto benchBackend = [&](const char* name, ProcessTaskSampler::Backend backend) {
+    ProcessTaskSampler sampler(getpid(), backend);
+    if (sampler.backend != backend) {
+      cpu_monitor_LOGW("%s not available", name);
+      return;
+    }
+    BENCH(name, 2000, [&] {
+      sampler.sample();
+      sink += sampler.samples.size();
+    });
+  };
+  benchBackend("PROCFS (<tid>/stat, status)", ProcessTaskSampler::Backend::PROCFS);
+  benchBackend("SCHEDSTAT (<tid>/schedstat, status)", ProcessTaskSampler::Backend::SCHEDSTAT);
+  benchBackend("TASKSTATS (netlink)", ProcessTaskSampler::Backend::TASKSTATS);
+
+  stop = true;
+  for (auto& thread : threads) {
+    thread.join();
+  }
+  printf("sink: %llu\n", (unsigned long long)sink);
+  return 0;
+}
@@ -0,0 +1,74 @@
+#include <unistd.h>
+
+#include <cstdio>
+#include <fstream>
+#include <sstream>
+#include <string>
+
+#include "bench_def.h"
+#include "detail/log.h"
+#include "detail/proc_file.h"
+#include "linux/TaskStat.h"
+
+using namespace cpu_monitor;
+
+/**
+ * the operator>> based reader TaskMonitor used before, kept as the baseline
+ */
+struct StreamTaskStat {
+  uint64_t id;
+  std::string name;
+  char task_state;
+  uint64_t fields[41 - 3];
+
+  void read(std::istream& is) {
+    is >> id >> name >> task_state;
+    for (auto& field : fields) {
+      int64_t value;
+      is >> value;
+      field = value;
+    }
+  }
+};
+
+int main() {
+  const std::string line =
+      "3864 (Worker Pool 3) S 3860 3864 3860 0 -1 4194304 81 7 3 1 1234 567 89 10 20 0 1 0 106090 2703360 299 18446744073709551615 "
+      "94470490361856 94470490381737 140724004621504 0 0 0 0 0 0 0 0 0 17 0 0 0 0 0 0\n";
+
+  cpu_monitor_LOGI("=> parse in memory");
+  uint64_t sink = 0;
+  BENCH("istringstream >> (41 fields)", 200000, [&] {
+    std::istringstream is(line);
+    StreamTaskStat stat;  // NOLINT
+    stat.read(is);
+    sink += stat.fields[10];
+  });
+  BENCH("TaskStat::parse", 200000, [&] {
+    detail::TaskStat stat;  // NOLINT
+    stat.parse(line.data(), line.data() + line.size());
+    sink += stat.utime;
+  });
+
+  cpu_monitor_LOGI("=> read /proc/self/task/<tid>/stat");
+  char path[64];
+  snprintf(path, sizeof(path), "/proc/%d/task/%d/stat", getpid(), getpid());
+  BENCH("fstream open + >>", 50000, [&] {
+    std::fstream file(path, std::fstream::in);
+    StreamTaskStat stat;  // NOLINT
+    stat.read(file);
+    sink += stat.fields[10];
+  });
+  detail::ProcFile file;
+  file.open(path);
+  BENCH("ProcFile pread + TaskStat::parse", 50000, [&] {
+    char buf[1024];
+    auto len = file.read(buf, sizeof(buf));
+    detail::TaskStat stat;  // NOLINT
+    stat.parse(buf, buf + len);
+    sink += stat.utime;
+  });
+
+  printf("sink: %llu\n", (unsigned long long)sink);
+  return 0;
+}
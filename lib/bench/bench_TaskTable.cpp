@@ -0,0 +1,98 @@
+#include <algorithm>
+#include <cstdio>
+#include <memory>
+#include <string>
+#include <vector>
+
+#include "ProcessTaskSampler.h"
+#include "TaskMonitor.h"
+#include "TaskTable.h"
+#include "bench_def.h"
+#include "detail/log.h"
+
+using namespace cpu_monitor;
+
+/**
+ * the find_if based diff the daemon used before, kept as the baseline
+ */
+static void updateByFind(std::vector<std::unique_ptr<TaskMonitor>>& tasks, const std::vector<TaskSample>& samples) {
+  for (auto iter = tasks.begin(); iter != tasks.cend();) {
+    auto id = (*iter)->id;
+    bool alive = std::find_if(samples.cbegin(), samples.cend(), [id](const TaskSample& sample) {
+                   return sample.id == id;
+                 }) != samples.cend();
+    iter = alive ? iter + 1 : tasks.erase(iter);
+  }
+  for (const auto& sample : samples) {
+    auto iter = std::find_if(tasks.begin(), tasks.end(), [&sample](const std::unique_ptr<TaskMonitor>& task) {
+      return task->id == sample.id;
+    });
+    if (iter == tasks.cend()) {
+      tasks.push_back(std::make_unique<TaskMonitor>(sample));
+    } else {
+      (*iter)->update(sample, 1000000000);
+    }
+  }
+}
+
+/**
+ * `threadNum` threads, every call 1% of them exit and the same number are born
+ */
+struct Samples {
+  std::vector<TaskSample> samples;
+  TaskId_t nextId;
+
+  explicit Samples(size_t threadNum) : samples(threadNum), nextId(1000) {
+    for (auto& sample : samples) {
+      sample = TaskSample{};
+      sample.id = nextId++;
+      snprintf(sample.name, sizeof(sample.name), "worker-%u", sample.id);
+    }
+  }
+
+  const std::vector<TaskSample>& next() {
+    auto churn = std::max<size_t>(1, samples.size() / 100);
+    // the oldest exit, the new ones come last
+    std::rotate(samples.begin(), samples.begin() + (ptrdiff_t)churn, samples.end());
+    for (auto sample = samples.end() - (ptrdiff_t)churn; sample != samples.end(); ++sample) {
+      *sample = TaskSample{};
+      sample->id = nextId++;
+      snprintf(sample->name, sizeof(sample->name), "worker-%u", sample->id);
+    }
+    for (auto& sample : samples) {
+      sample.cpuTimeNs += 1000000;
+    }
+    return samples;
+  }
+};
+
+int main() {
+  for (size_t threadNum : {10, 100, 1000, 4000, 10000, 50000}) {
+    cpu_monitor_LOGI("=> %zu threads, 1%% churn per update", threadNum);
+    char name[64];
+
+    // quadratic, keep the total work bounded
+    if (threadNum <= 10000) {
+      Samples input(threadNum);
+      std::vector<std::unique_ptr<TaskMonitor>> tasks;
+      updateByFind(tasks, input.next());
+      snprintf(name, sizeof(name), "find_if diff (%zu)", threadNum);
+      BENCH(name, std::max<int>(1, (int)(100000000 / (threadNum * threadNum))), [&] {
+        updateByFind(tasks, input.next());
+      });
+    } else {
+      cpu_monitor_LOGI("find_if diff skipped, too slow");
+    }
+
+    Samples input(threadNum);
+    std::vector<TaskSample> samples = input.next();
+    TaskTable table;
+    table.update(samples, 1000000000);
+    snprintf(name, sizeof(name), "TaskTable::update (%zu)", threadNum);
+    BENCH(name, std::max<int>(1, (int)(10000000 / threadNum)), [&] {
+      samples = input.next();
+      table.update(samples, 1000000000);
+    });
+  }
+  return 0;
+}
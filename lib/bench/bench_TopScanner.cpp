@@ -0,0 +1,43 @@
+#include <unistd.h>
+
+#include <atomic>
+#include <chrono>
+#include <thread>
+#include <vector>
+
+#include "TopScanner.h"
+#include "bench_def.h"
+#include "detail/log.h"
+
+using namespace cpu_monitor;
+
+int main() {
+  TopScanner scanner;
+  scanner.scan();
+  cpu_monitor_LOGI("=> processes: %zu, threads: %zu", scanner.processes, scanner.threads);
+  BENCH("TopScanner::scan idle threads skipped", 100, [&] {
+    scanner.scan();
+  });
+  cpu_monitor_LOGI("threads read: %zu", scanner.threadsRead);
+
+  // threads of this process are all read every scan: it is busy running the bench
+  std::atomic<bool> stop{false};
+  std::vector<std::thread> threads;
+  for (int i = 0; i < 2000; ++i) {
+    threads.emplace_back([&] {
+      while (!stop) std::this_thread::sleep_for(std::chrono::milliseconds(100));
+    });
+  }
+  scanner.scan();
+  cpu_monitor_LOGI("=> processes: %zu, threads: %zu", scanner.processes, scanner.threads);
+  auto cost = BENCH("TopScanner::scan 2000 busy threads", 20, [&] {
+    scanner.scan();
+  });
+  cpu_monitor_LOGI("threads read: %zu, %.1f ns per thread", scanner.threadsRead, cost / (double)scanner.threadsRead);
+
+  stop = true;
+  for (auto& thread : threads) {
+    thread.join();
+  }
+  return 0;
+}
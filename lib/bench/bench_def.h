@@ -0,0 +1,19 @@
+#pragma once
+
+#include <chrono>
+#include <cstdio>
+
+/**
+ * run `func` `times` times and print the average cost
+ * @return ns per call
+ */
+template <typename Func>
+static inline double BENCH(const char* name, int times, Func&& func) {
+  auto start = std::chrono::steady_clock::now();
+  for (int i = 0; i < times; ++i) {
+    func();
+  }
+  auto cost = std::chrono::duration<double, std::nano>(std::chrono::steady_clock::now() - start).count() / times;
+  printf("%-48s %12.1f ns/op\n", name, cost);
+  return cost;
+}
@@ -0,0 +1,77 @@
+#pragma once
+
+#include <fcntl.h>
+#include <unistd.h>
+
+#include <cerrno>
+#include <vector>
+
+#include "noncopyable.hpp"
+
+namespace cpu_monitor {
+namespace detail {
+
+/**
+ * Keep a procfs file open and re-read it from offset 0 with pread,
+ * so the kernel regenerates the content without a path lookup or open/close per read.
+ */
+class ProcFile : noncopyable {
+ public:
+  ProcFile() = default;
+  ~ProcFile() {
+    close();
+  }
+
+  bool open(const char* path) {
+    close();
+    fd_ = ::open(path, O_RDONLY | O_CLOEXEC);
+    return fd_ >= 0;
+  }
+
+  bool openAt(int dirFd, const char* path) {
+    close();
+    fd_ = ::openat(dirFd, path, O_RDONLY | O_CLOEXEC);
+    return fd_ >= 0;
+  }
+
+  bool isOpen() const {
+    return fd_ >= 0;
+  }
+
+  void close() {
+    if (fd_ < 0) return;
+    ::close(fd_);
+    fd_ = -1;
+  }
+
+  /**
+   * read at most `size` bytes from the beginning of the file
+   * @return bytes read, or -1 with errno set
+   */
+  ssize_t read(char* buf, size_t size) const {
+    ssize_t ret;
+    do {
+      ret = ::pread(fd_, buf, size, 0);
+    } while (ret < 0 && errno == EINTR);
+    return ret;
+  }
+
+  /**
+   * read the whole file into `buf`, the buffer only grows when the content does not fit
+   * @return bytes read, or -1 with errno set
+   */
+  ssize_t readAll(std::vector<char>& buf) const {
+    if (buf.empty()) buf.resize(4096);
+    for (;;) {
+      auto ret = read(buf.data(), buf.size());
+      if (ret < 0 || (size_t)ret < buf.size()) return ret;
+      buf.resize(buf.size() * 2);
+    }
+  }
+
+ private:
+  int fd_ = -1;
+};
+
+}  // namespace detail
+}  // namespace cpu_monitor
@@ -0,0 +1,45 @@
+#pragma once
+
+#include <cstdint>
+#include <string>
+#include <unordered_map>
+#include <vector>
+
+namespace cpu_monitor {
+namespace detail {
+
+/**
+ * Intern strings to small indexes, equal strings share one index
+ * strings are never removed, rebuild the pool to drop the unused ones
+ */
+class StringPool {
+ public:
+  uint32_t intern(const char* str) {
+    auto iter = index_.find(str);
+    if (iter != index_.cend()) return iter->second;
+    auto id = (uint32_t)strings_.size();
+    strings_.emplace_back(str);
+    index_.emplace(strings_.back(), id);
+    return id;
+  }
+
+  const std::string& get(uint32_t id) const {
+    return strings_[id];
+  }
+
+  size_t size() const {
+    return strings_.size();
+  }
+
+  void clear() {
+    strings_.clear();
+    index_.clear();
+  }
+
+ private:
+  std::vector<std::string> strings_;
+  std::unordered_map<std::string, uint32_t> index_;
+};
+
+}  // namespace detail
+}  // namespace cpu_monitor
@@ -0,0 +1,156 @@
+#include "CgroupMonitor.h"
+
+#include <cstdio>
+#include <cstring>
+#include <initializer_list>
+
+#include "ProcParse.h"
+
+namespace cpu_monitor {
+
+namespace {
+
+struct Field {
+  const char *name;
+  uint64_t *value;
+};
+
+/**
+ * parse lines like `usage_usec 4523410`, fields not found are left unchanged
+ */
+void parseFields(const char *p, const char *end, std::initializer_list<Field> fields) {
+  using namespace detail::ProcParse;
+  for (; p < end; p = nextLine(p, end)) {
+    auto space = (const char *)memchr(p, ' ', end - p);
+    if (space == nullptr) break;
+    size_t nameLen = space - p;
+    for (const auto &field : fields) {
+      if (strncmp(field.name, p, nameLen) != 0 || field.name[nameLen] != '\0') continue;
+      parseU64(space, end, field.value);
+      break;
+    }
+  }
+}
+
+/**
+ * parse a limit like `max` or `50000`
+ * @return position after the value, 0 is stored for `max`
+ */
+const char *parseLimit(const char *p, const char *end, uint64_t *value) {
+  using namespace detail::ProcParse;
+  p = skipSpaces(p, end);
+  if (end - p >= 3 && memcmp(p, "max", 3) == 0) {
+    *value = 0;
+    return p + 3;
+  }
+  return parseU64(p, end, value);
+}
+
+std::string findRoot() {
+  FILE *fp = fopen("/proc/self/mounts", "re");
+  if (fp == nullptr) return {};
+  // device mountpoint type options
+  char line[1024];
+  char mountPoint[512];
+  char type[32];
+  std::string root;
+  while (fgets(line, sizeof(line), fp)) {
+    if (sscanf(line, "%*s %511s %31s", mountPoint, type) != 2) continue;
+    if (strcmp(type, "cgroup2") == 0) {
+      root = mountPoint;
+      break;
+    }
+  }
+  fclose(fp);
+  return root;
+}
+
+}  // namespace
+
+std::string CgroupMonitor::root() {
+  static const std::string root = findRoot();
+  return root;
+}
+
+std::string CgroupMonitor::pathOfPid(PID_t pid) {
+  if (pid == 0) pid = getpid();
+  char path[64];
+  snprintf(path, sizeof(path), "/proc/%d/cgroup", pid);
+  detail::ProcFile file;
+  if (!file.open(path)) return {};
+  std::vector<char> buf;
+  auto len = file.readAll(buf);
+  if (len <= 0) return {};
+
+  // `hierarchy-ID:controller-list:cgroup-path`, the unified hierarchy is `0::`
+  using namespace detail::ProcParse;
+  const char *end = buf.data() + len;
+  for (const char *p = buf.data(); p < end; p = nextLine(p, end)) {
+    if (end - p < 3 || memcmp(p, "0::", 3) != 0) continue;
+    auto lineEnd = (const char *)memchr(p, '\n', end - p);
+    return std::string(p + 3, lineEnd ? lineEnd : end);
+  }
+  return {};
+}
+
+std::string CgroupMonitor::dir(const std::string &path) {
+  auto root = CgroupMonitor::root();
+  if (root.empty()) return {};
+  auto dir = path.compare(0, root.size(), root) == 0 ? path : root + path;
+  if (dir.back() != '/') dir += '/';
+  return dir;
+}
+
+CgroupMonitor::CgroupMonitor(const std::string &path) : path(path), dir_(dir(path)) {
+  if (dir_.empty()) return;
+
+  auto openFile = [this](detail::ProcFile &file, const char *name) {
+    file.open((dir_ + name).c_str());
+  };
+  openFile(cpuStatFile_, "cpu.stat");
+  // the files of a controller exist only if it is enabled in the parent, and not in the root
+  openFile(cpuMaxFile_, "cpu.max");
+  openFile(memCurrentFile_, "memory.current");
+  openFile(memMaxFile_, "memory.max");
+  openFile(memStatFile_, "memory.stat");
+  openFile(memEventsFile_, "memory.events");
+  buf_.resize(8192);
+}
+
+bool CgroupMonitor::sample(Sample *sample) {
+  // the files of a removed cgroup read as ENODEV
+  *sample = Sample{};
+  if (!cpuStatFile_.isOpen()) return false;
+  auto len = cpuStatFile_.readAll(buf_);
+  if (len <= 0) return false;
+  parseFields(buf_.data(), buf_.data() + len,
+              {{"usage_usec", &sample->usageUsec},
+               {"user_usec", &sample->userUsec},
+               {"system_usec", &sample->systemUsec},
+               {"nr_periods", &sample->nrPeriods},
+               {"nr_throttled", &sample->nrThrottled},
+               {"throttled_usec", &sample->throttledUsec}});
+
+  char value[64];
+  if (cpuMaxFile_.isOpen() && (len = cpuMaxFile_.read(value, sizeof(value))) > 0) {
+    auto p = parseLimit(value, value + len, &sample->quotaUsec);
+    if (p) detail::ProcParse::parseU64(p, value + len, &sample->periodUsec);
+  }
+  if (memCurrentFile_.isOpen() && (len = memCurrentFile_.read(value, sizeof(value))) > 0) {
+    detail::ProcParse::parseU64(value, value + len, &sample->memCurrent);
+  }
+  if (memMaxFile_.isOpen() && (len = memMaxFile_.read(value, sizeof(value))) > 0) {
+    parseLimit(value, value + len, &sample->memMax);
+  }
+  if (memStatFile_.isOpen() && (len = memStatFile_.readAll(buf_)) > 0) {
+    parseFields(buf_.data(), buf_.data() + len,
+                {{"anon", &sample->anon}, {"file", &sample->file}, {"kernel", &sample->kernel}, {"shmem", &sample->shmem}});
+  }
+  if (memEventsFile_.isOpen() && (len = memEventsFile_.readAll(buf_)) > 0) {
+    parseFields(buf_.data(), buf_.data() + len,
+                {{"high", &sample->highEvents}, {"max", &sample->maxEvents}, {"oom", &sample->oomEvents}, {"oom_kill", &sample->oomKills}});
+  }
+  return true;
+}
+
+}  // namespace cpu_monitor
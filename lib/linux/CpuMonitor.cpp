@@ -2,26 +2,61 @@
 
 #include <stdexcept>
 
+#include "CpuStat.h"
 #include "detail/defer.h"
 #include "detail/log.h"
 #include "sys/sysinfo.h"
 
 namespace cpu_monitor {
 
-CpuMonitor::CpuMonitor() {
+CpuMonitor::CpuMonitor(ReadMode mode) : readMode_(mode) {
   ave = std::make_unique<CpuMonitorCore>();
 
-  int cpuNum = get_nprocs();
-  cpu_monitor_LOGI("cpuNum: %d", cpuNum);
-  for (int i = 0; i < cpuNum; i++) {
-    auto monitor = std::make_unique<CpuMonitorCore>();
-    cores.push_back(std::move(monitor));
+  // configured cpus include the offline ones, which have no line in /proc/stat
+  int cpuNum = get_nprocs_conf();
+  cpu_monitor_LOGI("cpuNum: %d, online: %d", cpuNum, get_nprocs());
+  resizeCores(cpuNum);
+
+  if (readMode_ == ReadMode::PREAD) {
+    if (statFile_.open("/proc/stat")) {
+      // cpu lines are about 64 bytes each, leave room for the rest of the file
+      statBuf_.resize(4096 + 128 * (cpuNum + 1));
+    } else {
+      cpu_monitor_LOGE("open failed: /proc/stat, fallback to stdio");
+      readMode_ = ReadMode::STDIO;
+    }
   }
 
   update();
 }
 
 void CpuMonitor::update(bool updateCores) {
+  if (readMode_ == ReadMode::PREAD) {
+    updateByPread(updateCores);
+  } else {
+    updateByStdio(updateCores);
+  }
+}
+
+void CpuMonitor::resizeCores(size_t num) {
+  while (cores.size() < num) {
+    auto monitor = std::make_unique<CpuMonitorCore>();
+    monitor->id = (int)cores.size();
+    monitor->name = "cpu" + std::to_string(monitor->id);
+    monitor->online = false;
+    cores.push_back(std::move(monitor));
+  }
+  table_.resize(cores.size() + 1);
+}
+
+void CpuMonitor::dump() const {
+  ave->dump();
+  for (const auto &item : cores) {
+    item->dump();
+  }
+}
+
+void CpuMonitor::updateByStdio(bool updateCores) {
   FILE *fp = fopen("/proc/stat", "r");
   if (fp == nullptr) {
     cpu_monitor_LOGE("open failed: /proc/stat");
@@ -31,19 +66,76 @@ void CpuMonitor::update(bool updateCores) {
     fclose(fp);
   };
 
-  ave->update(fp);
+  detail::CpuStat stat;  // NOLINT
+  if (!stat.read(fp)) throw std::runtime_error("CpuMonitor::update failed");
+  setTicks(stat);
+
+  if (updateCores) {
+    setAllOffline();
+    while (stat.read(fp)) {
+      setTicks(stat);
+    }
+  }
+  updateViews(updateCores ? table_.rows() : 1);
+}
 
-  if (!updateCores) return;
+void CpuMonitor::updateByPread(bool updateCores) {
+  auto len = statFile_.readAll(statBuf_);
+  if (len <= 0) {
+    cpu_monitor_LOGE("read failed: /proc/stat");
+    return;
+  }
 
-  for (const auto &item : cores) {
-    item->update(fp);
+  const char *p = statBuf_.data();
+  const char *end = p + len;
+
+  detail::CpuStat stat;  // NOLINT
+  p = stat.parse(p, end);
+  if (p == nullptr) throw std::runtime_error("CpuMonitor::update failed");
+  setTicks(stat);
+
+  if (updateCores) {
+    setAllOffline();
+    while ((p = stat.parse(p, end)) != nullptr) {
+      setTicks(stat);
+    }
   }
+  updateViews(updateCores ? table_.rows() : 1);
 }
 
-void CpuMonitor::dump() const {
-  ave->dump();
+void CpuMonitor::setTicks(const detail::CpuStat &stat) {
+  int id = stat.parseId();
+  if (id < 0) {
+    if (ave->name != stat.name) ave->name = stat.name;
+    table_.setTicks(0, stat.ticks);
+    return;
+  }
+
+  // the lines of offline cores are missing, so a line is matched to its core by id instead of by position
+  if ((size_t)id >= cores.size()) {
+    cpu_monitor_LOGI("cpu added: %s", stat.name);
+    resizeCores(id + 1);
+  }
+  cores[id]->online = true;
+  table_.setTicks(id + 1, stat.ticks);
+}
+
+void CpuMonitor::setAllOffline() {
   for (const auto &item : cores) {
-    item->dump();
+    item->online = false;
+  }
+}
+
+void CpuMonitor::updateViews(size_t rows) {
+  table_.update(rows);
+  for (size_t row = 0; row < rows; ++row) {
+    auto &view = row == 0 ? *ave : *cores[row - 1];
+    view.usage = table_.usage(row);
+    view.totalTime = table_.totalTime(row);
+    view.idleTime = table_.idleTime(row);
+    for (int type = 0; type < CpuT::TYPE_NUM; ++type) {
+      view.times[type] = table_.time(row, type);
+    }
   }
 }
 
@@ -10,49 +10,28 @@ namespace cpu_monitor {
 CpuMonitorCore::CpuMonitorCore() = default;
 
 void CpuMonitorCore::update(CpuInfoNative *p) {
+  detail::CpuStat cpuTick;  // NOLINT
+  if (!cpuTick.read(p)) throw std::runtime_error("CpuMonitorCore::update failed");
+  update(cpuTick);
+}
+
+void CpuMonitorCore::update(const detail::CpuStat &stat) {
   invertAB();
   {
-    using namespace detail;
-    detail::CpuStat cpuTick;  // NOLINT
-    // clang-format off
-    int ret = fscanf(p, // NOLINT
-          "%s"
-          " %" PRIu64
-          " %" PRIu64
-          " %" PRIu64
-          " %" PRIu64
-          " %" PRIu64
-          " %" PRIu64
-          " %" PRIu64
-          " %" PRIu64
-          " %" PRIu64
-          " %" PRIu64
-          "\n",
-          cpuTick.name,
-          &(cpuTick.ticks[CpuT::USER]),
-          &(cpuTick.ticks[CpuT::NICE]),
-          &(cpuTick.ticks[CpuT::SYSTEM]),
-          &(cpuTick.ticks[CpuT::IDLE]),
-          &(cpuTick.ticks[CpuT::IOWAIT]),
-          &(cpuTick.ticks[CpuT::IRQ]),
-          &(cpuTick.ticks[CpuT::SOFTIRQ]),
-          &(cpuTick.ticks[CpuT::STEAL]),
-          &(cpuTick.ticks[CpuT::GUEST]),
-          &(cpuTick.ticks[CpuT::GUEST_NICE]));
-    // clang-format on
-    if (!ret) throw std::runtime_error("CpuMonitorCore::update failed");
-
-    name = cpuTick.name;
+    name = stat.name;
 
     auto &t = tickCur();
-    t.idleTicks = cpuTick.calcTicksIdle();
-    t.totalTicks = cpuTick.calcTicksTotal();
+    for (int type = 0; type < CpuT::TYPE_NUM; ++type) {
+      t.ticks[type] = stat.ticks[type];
+    }
+    t.totalTicks = stat.calcTicksTotal();
   }
   calcUsage();
 }
 
 void CpuMonitorCore::dump() const {
-  cpu_monitor_LOGI("%s: usage: %.2f%%", name.c_str(), usage);
+  cpu_monitor_LOGI("%s: usage: %.2f%%, user: %.2f%%, system: %.2f%%, iowait: %.2f%%, softirq: %.2f%%, steal: %.2f%%", name.c_str(), usage,
+                   times[CpuT::USER], times[CpuT::SYSTEM], times[CpuT::IOWAIT], times[CpuT::SOFTIRQ], times[CpuT::STEAL]);
 }
 
 void CpuMonitorCore::invertAB() {
@@ -68,10 +47,23 @@ CpuTick &CpuMonitorCore::tickPre() {
 }
 
 void CpuMonitorCore::calcUsage() {
-  totalTime = tickCur().totalTicks - tickPre().totalTicks;
-  idleTime = tickCur().idleTicks - tickPre().idleTicks;
-  uint64_t active = totalTime - idleTime;
-  usage = active * 100.f / totalTime;  // NOLINT
+  auto &cur = tickCur();
+  auto &pre = tickPre();
+  // start over from the current ticks if the counters restarted
+  bool reset = cur.isResetFrom(pre);
+  uint64_t deltas[CpuT::TYPE_NUM];
+  totalTime = 0;
+  for (int type = 0; type < CpuT::TYPE_NUM; ++type) {
+    deltas[type] = reset ? 0 : calcTickDelta(cur.ticks[type], pre.ticks[type]);
+    totalTime += deltas[type];
+  }
+  idleTime = deltas[CpuT::IDLE] + deltas[CpuT::IOWAIT];
+
+  float scale = totalTime ? 100.f / totalTime : 0;
+  usage = (totalTime - idleTime) * scale;
+  for (int type = 0; type < CpuT::TYPE_NUM; ++type) {
+    times[type] = deltas[type] * scale;
+  }
 }
 
 }  // namespace cpu_monitor
@@ -1,47 +1,106 @@
 #pragma once
 
+#include <cinttypes>
 #include <cstdint>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+
+#include "CpuTick.h"
+#include "ProcParse.h"
 
 namespace cpu_monitor {
 namespace detail {
 
-namespace CpuT {
-enum : int {
-  USER = 0,
-  NICE,
-  SYSTEM,
-  IDLE,
-  IOWAIT,
-  IRQ,
-  SOFTIRQ,
-  STEAL,
-  GUEST,
-  GUEST_NICE,
-  TYPE_NUM,
-};
-}
-
 struct CpuStat {
   char name[16];
 
-  uint64_t calcTicksIdle() {
+  uint64_t calcTicksIdle() const {
     return ticks[CpuT::IDLE] + ticks[CpuT::IOWAIT];
   }
 
-  uint64_t calcTicksTotal() {
+  uint64_t calcTicksTotal() const {
     uint64_t total = 0;
     for (auto tick : ticks) total += tick;
     return total;
   }
 
-  uint64_t calcTicksSystem() {
+  uint64_t calcTicksSystem() const {
     return ticks[CpuT::SYSTEM];
   }
 
-  uint64_t calcTicksUser() {
+  uint64_t calcTicksUser() const {
     return ticks[CpuT::USER];
   }
 
+  /**
+   * @return N of `cpuN`, -1 for the `cpu` line
+   */
+  int parseId() const {
+    return name[3] ? atoi(name + 3) : -1;
+  }
+
+  /**
+   * parse one `cpu`/`cpuN` line of /proc/stat
+   * missing trailing fields (old kernels) are set to 0
+   * @return position of the next line, or nullptr if `p` is not a cpu line
+   */
+  const char *parse(const char *p, const char *end) {
+    using namespace ProcParse;
+    if (end - p < 3 || strncmp(p, "cpu", 3) != 0) return nullptr;
+
+    auto nameEnd = skipToken(p, end);
+    size_t nameLen = nameEnd - p;
+    if (nameLen >= sizeof(name)) nameLen = sizeof(name) - 1;
+    memcpy(name, p, nameLen);
+    name[nameLen] = '\0';
+
+    p = nameEnd;
+    for (auto &tick : ticks) {
+      auto next = parseU64(p, end, &tick);
+      if (next) {
+        p = next;
+      } else {
+        tick = 0;
+      }
+    }
+    return nextLine(p, end);
+  }
+
+  /**
+   * read one cpu line by fscanf
+   * @return false if nothing is matched or it is not a cpu line, which is consumed then
+   */
+  bool read(FILE *fp) {
+    // clang-format off
+    int ret = fscanf(fp, // NOLINT
+          "%15s"
+          " %" PRIu64
+          " %" PRIu64
+          " %" PRIu64
+          " %" PRIu64
+          " %" PRIu64
+          " %" PRIu64
+          " %" PRIu64
+          " %" PRIu64
+          " %" PRIu64
+          " %" PRIu64
+          "\n",
+          name,
+          &(ticks[CpuT::USER]),
+          &(ticks[CpuT::NICE]),
+          &(ticks[CpuT::SYSTEM]),
+          &(ticks[CpuT::IDLE]),
+          &(ticks[CpuT::IOWAIT]),
+          &(ticks[CpuT::IRQ]),
+          &(ticks[CpuT::SOFTIRQ]),
+          &(ticks[CpuT::STEAL]),
+          &(ticks[CpuT::GUEST]),
+          &(ticks[CpuT::GUEST_NICE]));
+    // clang-format on
+    return ret > 0 && strncmp(name, "cpu", 3) == 0;
+  }
+
   uint64_t ticks[CpuT::TYPE_NUM];
 };
 
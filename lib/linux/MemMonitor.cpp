@@ -1,67 +1,64 @@
 #include "MemMonitor.h"
 
 #include <cstdio>
-#include <cstdlib>
 #include <cstring>
+#include <initializer_list>
 
+#include "ProcParse.h"
 #include "detail/defer.h"
 
 namespace cpu_monitor {
 
+namespace {
+
+const size_t PageKB = sysconf(_SC_PAGESIZE) / 1024;
+
+struct Field {
+  const char *name;
+  size_t *value;
+};
+
+/**
+ * parse lines like `VmRSS:	    2696 kB`, fields not found are left unchanged
+ */
+void parseFields(const char *p, const char *end, std::initializer_list<Field> fields) {
+  using namespace detail::ProcParse;
+  for (; p < end; p = nextLine(p, end)) {
+    auto colon = (const char *)memchr(p, ':', end - p);
+    if (colon == nullptr) break;
+    size_t nameLen = colon - p;
+    for (const auto &field : fields) {
+      if (strncmp(field.name, p, nameLen) != 0 || field.name[nameLen] != '\0') continue;
+      uint64_t value;
+      if (parseU64(colon + 1, end, &value)) *field.value = value;
+      break;
+    }
+  }
+}
+
+bool openProcFile(detail::ProcFile &file, PID_t pid, const char *name) {
+  char path[64];
+  snprintf(path, sizeof(path), "/proc/%d/%s", pid, name);
+  return file.open(path);
+}
+
+}  // namespace
+
 MemMonitor::UsageRet MemMonitor::getUsage(PID_t pid) {
   if (pid == 0) pid = getpid();
-  char filePath[64];
-  snprintf(filePath, sizeof(filePath), "/proc/%d/status", pid);
 
-  UsageRet usageRet;  // NOLINT
+  UsageRet usageRet{};
   auto &result = usageRet.usage;
 
-  char buf[64];
-  auto getValue = [&buf] {
-    char *startPos = nullptr;
-    char *endPos = nullptr;
-
-    char *p = buf;
-    do {
-      char c = *p;
-      if (c == 0) break;
-      if (startPos != nullptr) {
-        if (c == ' ') endPos = p;
-      } else if (c >= '0' && c <= '9') {
-        startPos = p;
-      }
-    } while (p++);
-    *endPos = 0;
-    return std::strtol(startPos, nullptr, 10);
-  };
-  auto startWith = [&buf](const char *str) {
-    return strncmp(buf, str, strlen(str)) == 0;
-  };
+  detail::ProcFile file;
+  if (!openProcFile(file, pid, "status")) return usageRet;
+  std::vector<char> buf;
+  auto len = file.readAll(buf);
+  if (len <= 0) return usageRet;
 
-  FILE *fp = fopen(filePath, "r");
-  defer {
-    if (fp == nullptr) return;
-    fclose(fp);
-  };
-
-  if (fp == nullptr) {
-    usageRet.ok = false;
-  } else {
-    usageRet.ok = true;
-    while (!feof(fp)) {
-      auto r = fgets(buf, sizeof(buf), fp);
-      (void)r;
-      if (startWith("VmPeak:")) {
-        result.VmPeak = getValue();
-      } else if (startWith("VmSize:")) {
-        result.VmSize = getValue();
-      } else if (startWith("VmHWM:")) {
-        result.VmHWM = getValue();
-      } else if (startWith("VmRSS:")) {
-        result.VmRSS = getValue();
-      }
-    }
-  }
+  parseFields(buf.data(), buf.data() + len,
+              {{"VmPeak", &result.VmPeak}, {"VmSize", &result.VmSize}, {"VmHWM", &result.VmHWM}, {"VmRSS", &result.VmRSS}});
+  usageRet.ok = true;
   return usageRet;
 }
 
@@ -80,4 +77,52 @@ void MemMonitor::dumpUsage(PID_t pid) {
   fclose(fp);
 }
 
+MemMonitor::MemMonitor(PID_t pid) : pid(pid == 0 ? getpid() : pid) {
+  openProcFile(statmFile_, this->pid, "statm");
+  buf_.resize(4096);
+}
+
+bool MemMonitor::sampleStatm(Statm *statm) {
+  char buf[128];
+  auto len = statmFile_.read(buf, sizeof(buf));
+  if (len <= 0) return false;
+
+  // size resident shared text lib data dt, in pages
+  using namespace detail::ProcParse;
+  uint64_t pages[6];
+  const char *p = buf;
+  const char *end = buf + len;
+  for (auto &page : pages) {
+    p = parseU64(p, end, &page);
+    if (p == nullptr) return false;
+  }
+  statm->VmSize = pages[0] * PageKB;
+  statm->VmRSS = pages[1] * PageKB;
+  statm->shared = pages[2] * PageKB;
+  statm->text = pages[3] * PageKB;
+  statm->data = pages[5] * PageKB;
+  return true;
+}
+
+bool MemMonitor::sampleRollup(Rollup *rollup) {
+  // opened on first use, it is opt-in
+  if (!rollupFile_.isOpen() && !openProcFile(rollupFile_, pid, "smaps_rollup")) return false;
+  if (!statusFile_.isOpen() && !openProcFile(statusFile_, pid, "status")) return false;
+
+  Rollup value{};
+  auto len = rollupFile_.readAll(buf_);
+  if (len <= 0) return false;
+  size_t privateClean = 0;
+  size_t privateDirty = 0;
+  parseFields(buf_.data(), buf_.data() + len,
+              {{"Pss", &value.Pss}, {"Private_Clean", &privateClean}, {"Private_Dirty", &privateDirty}, {"Swap", &value.Swap}});
+  value.Uss = privateClean + privateDirty;
+
+  len = statusFile_.readAll(buf_);
+  if (len <= 0) return false;
+  parseFields(buf_.data(), buf_.data() + len, {{"RssAnon", &value.RssAnon}, {"RssFile", &value.RssFile}, {"RssShmem", &value.RssShmem}});
+  *rollup = value;
+  return true;
+}
+
 }  // namespace cpu_monitor
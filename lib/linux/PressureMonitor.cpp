@@ -0,0 +1,126 @@
+#include "PressureMonitor.h"
+
+#include <poll.h>
+
+#include <cerrno>
+#include <cstdio>
+#include <cstring>
+
+#include "CgroupMonitor.h"
+#include "ProcParse.h"
+
+namespace cpu_monitor {
+
+namespace {
+
+std::string pathOf(PressureMonitor::Resource resource, const std::string &cgroup) {
+  auto name = PressureMonitor::name(resource);
+  if (cgroup.empty()) return std::string("/proc/pressure/") + name;
+  auto dir = CgroupMonitor::dir(cgroup);
+  if (dir.empty()) return {};
+  return dir + name + ".pressure";
+}
+
+/**
+ * parse an average like `6.46`, always printed with 2 decimals by the kernel
+ */
+const char *parseAvg(const char *p, const char *end, float *value) {
+  using namespace detail::ProcParse;
+  uint64_t integer;
+  p = parseU64(p, end, &integer);
+  if (p == nullptr) return nullptr;
+  uint64_t fraction = 0;
+  float scale = 1;
+  if (p < end && *p == '.') {
+    auto begin = ++p;
+    p = parseU64(p, end, &fraction);
+    if (p == nullptr) return nullptr;
+    for (auto i = begin; i < p; ++i) scale *= 10;
+  }
+  *value = (float)integer + (float)fraction / scale;
+  return p;
+}
+
+/**
+ * parse a line like `some avg10=6.46 avg60=10.42 avg300=11.70 total=354154058` after the kind
+ */
+bool parseStall(const char *p, const char *end, PressureMonitor::Stall *stall) {
+  using namespace detail::ProcParse;
+  // the order is fixed, skip the names
+  float *avgs[] = {&stall->avg10, &stall->avg60, &stall->avg300};
+  for (auto avg : avgs) {
+    p = (const char *)memchr(p, '=', end - p);
+    if (p == nullptr) return false;
+    p = parseAvg(p + 1, end, avg);
+    if (p == nullptr) return false;
+  }
+  p = (const char *)memchr(p, '=', end - p);
+  return p && parseU64(p + 1, end, &stall->totalUsec);
+}
+
+}  // namespace
+
+PressureMonitor::PressureMonitor(Resource resource, const std::string &cgroup) : resource(resource), cgroup(cgroup) {
+  auto path = pathOf(resource, cgroup);
+  if (!path.empty()) file_.open(path.c_str());
+}
+
+bool PressureMonitor::sample(Sample *sample) {
+  *sample = Sample{};
+  if (!file_.isOpen()) return false;
+  char buf[256];
+  auto len = file_.read(buf, sizeof(buf));
+  if (len <= 0) return false;
+
+  using namespace detail::ProcParse;
+  const char *end = buf + len;
+  bool ok = false;
+  for (const char *p = buf; p < end; p = nextLine(p, end)) {
+    auto lineEnd = nextLine(p, end);
+    if (end - p > 4 && memcmp(p, "some", 4) == 0) {
+      ok = parseStall(p + 4, lineEnd, &sample->some);
+    } else if (end - p > 4 && memcmp(p, "full", 4) == 0) {
+      parseStall(p + 4, lineEnd, &sample->full);
+    }
+  }
+  return ok;
+}
+
+PressureTrigger::~PressureTrigger() {
+  if (fd_ >= 0) close(fd_);
+}
+
+bool PressureTrigger::open(PressureMonitor::Resource resource, const std::string &cgroup, bool full, uint32_t stallUs, uint32_t windowUs) {
+  if (fd_ >= 0) {
+    close(fd_);
+    fd_ = -1;
+  }
+  auto path = pathOf(resource, cgroup);
+  if (path.empty()) {
+    errno = ENOENT;
+    return false;
+  }
+  fd_ = ::open(path.c_str(), O_RDWR | O_NONBLOCK | O_CLOEXEC);
+  if (fd_ < 0) return false;
+
+  // the terminating `\0` is part of the trigger
+  char trigger[64];
+  auto len = snprintf(trigger, sizeof(trigger), "%s %u %u", full ? "full" : "some", stallUs, windowUs);
+  if (write(fd_, trigger, len + 1) < 0) {
+    int err = errno;
+    close(fd_);
+    fd_ = -1;
+    errno = err;
+    return false;
+  }
+  return true;
+}
+
+bool PressureTrigger::alive() const {
+  if (fd_ < 0) return false;
+  pollfd pfd{fd_, POLLPRI, 0};
+  if (poll(&pfd, 1, 0) < 0) return errno == EINTR;
+  return !(pfd.revents & (POLLERR | POLLNVAL));
+}
+
+}  // namespace cpu_monitor
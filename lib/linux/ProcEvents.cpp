@@ -0,0 +1,113 @@
+#include "ProcEvents.h"
+
+#include <linux/cn_proc.h>
+#include <linux/connector.h>
+#include <linux/netlink.h>
+#include <sys/socket.h>
+#include <unistd.h>
+
+#include <cerrno>
+#include <cstring>
+
+namespace cpu_monitor {
+
+namespace {
+
+bool sendMcastOp(int fd, proc_cn_mcast_op op) {
+  alignas(8) char msg[NLMSG_SPACE(sizeof(cn_msg) + sizeof(op))]{};
+  auto nlh = reinterpret_cast<nlmsghdr *>(msg);
+  nlh->nlmsg_len = NLMSG_LENGTH(sizeof(cn_msg) + sizeof(op));
+  nlh->nlmsg_type = NLMSG_DONE;
+  nlh->nlmsg_pid = 0;
+
+  auto cn = static_cast<cn_msg *>(NLMSG_DATA(nlh));
+  cn->id.idx = CN_IDX_PROC;
+  cn->id.val = CN_VAL_PROC;
+  cn->len = sizeof(op);
+  memcpy(cn->data, &op, sizeof(op));
+
+  ssize_t ret;
+  do {
+    ret = send(fd, msg, nlh->nlmsg_len, 0);
+  } while (ret < 0 && errno == EINTR);
+  return ret == (ssize_t)nlh->nlmsg_len;
+}
+
+}  // namespace
+
+ProcEvents::~ProcEvents() {
+  if (fd_ < 0) return;
+  sendMcastOp(fd_, PROC_CN_MCAST_IGNORE);
+  close(fd_);
+}
+
+bool ProcEvents::open() {
+  fd_ = socket(AF_NETLINK, SOCK_DGRAM | SOCK_NONBLOCK | SOCK_CLOEXEC, NETLINK_CONNECTOR);
+  if (fd_ < 0) return false;
+
+  sockaddr_nl addr{};
+  addr.nl_family = AF_NETLINK;
+  addr.nl_groups = CN_IDX_PROC;
+  // events of the whole system arrive in bursts on fork heavy hosts, give them room (capped by net.core.rmem_max)
+  int rcvBuf = 4 * 1024 * 1024;
+  setsockopt(fd_, SOL_SOCKET, SO_RCVBUF, &rcvBuf, sizeof(rcvBuf));
+  // EPERM: CAP_NET_ADMIN is required by the kernel
+  if (bind(fd_, reinterpret_cast<sockaddr *>(&addr), sizeof(addr)) < 0 || !sendMcastOp(fd_, PROC_CN_MCAST_LISTEN)) {
+    int err = errno;
+    close(fd_);
+    fd_ = -1;
+    errno = err;
+    return false;
+  }
+  return true;
+}
+
+bool ProcEvents::read(std::vector<ProcEvent> &events) {
+  bool lost = false;
+  for (;;) {
+    auto len = recv(fd_, buf_, sizeof(buf_), 0);
+    if (len < 0) {
+      if (errno == EINTR) continue;
+      // the error is reported once, the socket keeps working
+      if (errno == ENOBUFS) {
+        lost = true;
+        continue;
+      }
+      break;  // EAGAIN: drained
+    }
+
+    for (auto nlh = reinterpret_cast<const nlmsghdr *>(buf_); NLMSG_OK(nlh, len); nlh = NLMSG_NEXT(nlh, len)) {
+      if (nlh->nlmsg_type == NLMSG_ERROR || nlh->nlmsg_type == NLMSG_NOOP) continue;
+      auto cn = static_cast<const cn_msg *>(NLMSG_DATA(nlh));
+      if (cn->id.idx != CN_IDX_PROC || cn->id.val != CN_VAL_PROC) continue;
+      auto ev = reinterpret_cast<const proc_event *>(cn->data);
+
+      ProcEvent event{};
+      event.timestampNs = ev->timestamp_ns;
+      switch (ev->what) {
+        case proc_event::PROC_EVENT_FORK:
+          event.type = ProcEvent::Type::FORK;
+          event.pid = ev->event_data.fork.child_tgid;
+          event.tid = ev->event_data.fork.child_pid;
+          break;
+        case proc_event::PROC_EVENT_EXEC:
+          event.type = ProcEvent::Type::EXEC;
+          event.pid = ev->event_data.exec.process_tgid;
+          event.tid = ev->event_data.exec.process_pid;
+          break;
+        case proc_event::PROC_EVENT_EXIT:
+          event.type = ProcEvent::Type::EXIT;
+          event.pid = ev->event_data.exit.process_tgid;
+          event.tid = ev->event_data.exit.process_pid;
+          event.exitCode = (int)ev->event_data.exit.exit_code;
+          break;
+        default:
+          continue;
+      }
+      events.push_back(event);
+    }
+  }
+  return !lost;
+}
+
+}  // namespace cpu_monitor
@@ -0,0 +1,44 @@
+#pragma once
+
+#include <cstdint>
+
+#include "ProcParse.h"
+
+namespace cpu_monitor {
+namespace detail {
+
+/**
+ * /proc/<pid>/io
+ * like:
+ * rchar: 323934931
+ * wchar: 323929600
+ * syscr: 632687
+ * syscw: 632675
+ * read_bytes: 0
+ * write_bytes: 323932160
+ * cancelled_write_bytes: 0
+ */
+struct ProcIo {
+  uint64_t rchar;
+  uint64_t wchar;
+  uint64_t syscr;
+  uint64_t syscw;
+  uint64_t readBytes;
+  uint64_t writeBytes;
+
+  /**
+   * @return false if the content is truncated or malformed
+   */
+  bool parse(const char *p, const char *end) {
+    using namespace ProcParse;
+    for (auto field : {&rchar, &wchar, &syscr, &syscw, &readBytes, &writeBytes}) {
+      p = parseU64(skipToken(p, end), end, field);
+      if (p == nullptr) return false;
+      p = nextLine(p, end);
+    }
+    return true;
+  }
+};
+
+}  // namespace detail
+}  // namespace cpu_monitor
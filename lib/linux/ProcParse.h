@@ -0,0 +1,60 @@
+#pragma once
+
+#include <cstdint>
+
+namespace cpu_monitor {
+namespace detail {
+namespace ProcParse {
+
+inline bool isDigit(char c) {
+  return c >= '0' && c <= '9';
+}
+
+inline const char *skipSpaces(const char *p, const char *end) {
+  while (p < end && (*p == ' ' || *p == '\t')) ++p;
+  return p;
+}
+
+inline const char *skipToken(const char *p, const char *end) {
+  p = skipSpaces(p, end);
+  while (p < end && *p != ' ' && *p != '\t' && *p != '\n') ++p;
+  return p;
+}
+
+inline const char *nextLine(const char *p, const char *end) {
+  while (p < end && *p != '\n') ++p;
+  return p < end ? p + 1 : end;
+}
+
+/**
+ * parse an unsigned decimal after optional spaces
+ * @return position after the number, or nullptr if there is no number
+ */
+inline const char *parseU64(const char *p, const char *end, uint64_t *value) {
+  p = skipSpaces(p, end);
+  if (p == end || !isDigit(*p)) return nullptr;
+  uint64_t v = 0;
+  do {
+    v = v * 10 + (*p - '0');
+    ++p;
+  } while (p < end && isDigit(*p));
+  *value = v;
+  return p;
+}
+
+/**
+ * parse a decimal that may be negative (e.g. tty_pgrp is -1), stored as two's complement
+ * @return position after the number, or nullptr if there is no number
+ */
+inline const char *parseI64(const char *p, const char *end, uint64_t *value) {
+  p = skipSpaces(p, end);
+  bool negative = p < end && *p == '-';
+  if (negative) ++p;
+  p = parseU64(p, end, value);
+  if (p && negative) *value = 0 - *value;
+  return p;
+}
+
+}  // namespace ProcParse
+}  // namespace detail
+}  // namespace cpu_monitor
@@ -0,0 +1,108 @@
+#include "ProcessIndex.h"
+
+#include <fcntl.h>
+#include <linux/limits.h>
+#include <sys/syscall.h>
+#include <unistd.h>
+
+#include <algorithm>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+
+#include "ProcParse.h"
+#include "TaskStat.h"
+#include "detail/log.h"
+#include "detail/proc_file.h"
+
+namespace cpu_monitor {
+
+namespace {
+
+struct LinuxDirent64 {
+  uint64_t d_ino;
+  int64_t d_off;
+  unsigned short d_reclen;
+  unsigned char d_type;
+  char d_name[256];
+};
+
+// readlink of an unlinked executable
+const char DeletedSuffix[] = " (deleted)";
+
+}  // namespace
+
+// TASK_COMM_LEN - 1
+const size_t ProcessIndex::CommMaxLen = 15;
+
+ProcessIndex::ProcessIndex() {
+  procFd_ = open("/proc", O_RDONLY | O_DIRECTORY | O_CLOEXEC);
+  if (procFd_ < 0) cpu_monitor_LOGE("open /proc failed: %s", strerror(errno));
+  buf_.resize(32 * 1024);
+}
+
+ProcessIndex::~ProcessIndex() {
+  if (procFd_ >= 0) close(procFd_);
+}
+
+bool ProcessIndex::listPids(std::vector<PID_t> &pids) {
+  pids.clear();
+  if (procFd_ < 0) return false;
+  if (lseek(procFd_, 0, SEEK_SET) < 0) return false;
+  for (;;) {
+    auto len = syscall(SYS_getdents64, procFd_, buf_.data(), buf_.size());
+    if (len < 0) return false;
+    if (len == 0) break;
+
+    for (long pos = 0; pos < len;) {
+      auto dirent = reinterpret_cast<const LinuxDirent64 *>(buf_.data() + pos);
+      pos += dirent->d_reclen;
+      if (!detail::ProcParse::isDigit(dirent->d_name[0])) continue;
+      pids.push_back((PID_t)strtol(dirent->d_name, nullptr, 10));
+    }
+  }
+  return true;
+}
+
+bool ProcessIndex::readEntry(PID_t pid, Entry *entry) {
+  char path[32];
+  detail::ProcFile file;
+
+  // comm and ppid in one read
+  snprintf(path, sizeof(path), "%d/stat", pid);
+  if (!file.openAt(procFd_, path)) return false;
+  char stat[1024];
+  auto len = file.read(stat, sizeof(stat));
+  if (len <= 0) return false;
+  detail::TaskStat taskStat;  // NOLINT
+  if (!taskStat.parse(stat, stat + len)) return false;
+  entry->comm = taskStat.name;
+  entry->ppid = (PID_t)taskStat.ppid;
+
+  // EACCES for the processes of other users without CAP_SYS_PTRACE, ENOENT for kernel threads
+  entry->exe.clear();
+  snprintf(path, sizeof(path), "%d/exe", pid);
+  len = readlinkat(procFd_, path, buf_.data(), PATH_MAX);
+  if (len > 0) {
+    auto suffixLen = sizeof(DeletedSuffix) - 1;
+    if ((size_t)len > suffixLen && memcmp(buf_.data() + len - suffixLen, DeletedSuffix, suffixLen) == 0) len -= suffixLen;
+    auto end = buf_.data() + len;
+    auto name = std::find(std::reverse_iterator<char *>(end), std::reverse_iterator<char *>(buf_.data()), '/').base();
+    entry->exe.assign(name, end);
+  }
+
+  // arguments separated by `\0`, empty for kernel threads
+  entry->cmdline.clear();
+  snprintf(path, sizeof(path), "%d/cmdline", pid);
+  if (file.openAt(procFd_, path)) {
+    len = file.readAll(buf_);
+    while (len > 0 && buf_[len - 1] == '\0') --len;
+    if (len > 0) {
+      std::replace(buf_.begin(), buf_.begin() + len, '\0', ' ');
+      entry->cmdline.assign(buf_.data(), len);
+    }
+  }
+  return true;
+}
+
+}  // namespace cpu_monitor
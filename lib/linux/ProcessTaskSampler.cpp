@@ -0,0 +1,283 @@
+#include "ProcessTaskSampler.h"
+
+#include <fcntl.h>
+#include <sys/syscall.h>
+#include <unistd.h>
+
+#include <cerrno>
+#include <chrono>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+
+#include "ProcIo.h"
+#include "SchedStat.h"
+#include "TaskStat.h"
+#include "TaskStatsClient.h"
+#include "TaskStatus.h"
+#include "detail/log.h"
+#include "detail/proc_file.h"
+
+namespace cpu_monitor {
+
+namespace {
+
+struct LinuxDirent64 {
+  uint64_t d_ino;
+  int64_t d_off;
+  unsigned short d_reclen;
+  unsigned char d_type;
+  char d_name[256];
+};
+
+const uint64_t NsPerTick = 1000000000ULL / sysconf(_SC_CLK_TCK);
+
+// thread names may change after creation (pthread_setname_np), re-read all of them periodically
+const uint32_t NameRefreshSamples = 16;
+
+}  // namespace
+
+ProcessTaskSampler::ProcessTaskSampler(PID_t pid, Backend backend) : pid(pid), backend(backend) {
+  char path[64];
+  snprintf(path, sizeof(path), "/proc/%d/task", pid);
+  taskDirFd_ = open(path, O_RDONLY | O_DIRECTORY | O_CLOEXEC);
+  snprintf(path, sizeof(path), "/proc/%d/io", pid);
+  ioFile_.open(path);
+  direntBuf_.resize(32 * 1024);
+
+  if (backend == Backend::TASKSTATS) {
+    taskStats_ = std::make_unique<detail::TaskStatsClient>();
+    if (!taskStats_->open()) {
+      cpu_monitor_LOGW("taskstats not available: %s, fallback to procfs", strerror(errno));
+      taskStats_ = nullptr;
+      this->backend = Backend::PROCFS;
+    }
+  } else if (backend == Backend::SCHEDSTAT) {
+    char schedStatPath[32];
+    snprintf(schedStatPath, sizeof(schedStatPath), "%d/schedstat", pid);
+    detail::ProcFile file;
+    // ENOENT: the kernel is built without CONFIG_SCHED_INFO
+    if (taskDirFd_ >= 0 && !file.openAt(taskDirFd_, schedStatPath) && errno == ENOENT) {
+      cpu_monitor_LOGW("schedstat not available, fallback to procfs");
+      this->backend = Backend::PROCFS;
+    }
+  }
+}
+
+ProcessTaskSampler::~ProcessTaskSampler() {
+  if (taskDirFd_ >= 0) close(taskDirFd_);
+}
+
+bool ProcessTaskSampler::sample() {
+  beginSample();
+  if (taskDirFd_ < 0) return false;
+
+  if (lseek(taskDirFd_, 0, SEEK_SET) < 0) return false;
+  for (;;) {
+    auto len = syscall(SYS_getdents64, taskDirFd_, direntBuf_.data(), direntBuf_.size());
+    // ENOENT: the process has exited
+    if (len < 0) return false;
+    if (len == 0) break;
+
+    for (long pos = 0; pos < len;) {
+      auto dirent = reinterpret_cast<const LinuxDirent64 *>(direntBuf_.data() + pos);
+      pos += dirent->d_reclen;
+      if (!detail::ProcParse::isDigit(dirent->d_name[0])) continue;
+      // the thread may exit between getdents64 and reading it
+      readTask(dirent->d_name);
+    }
+  }
+  closeGoneTaskFiles();
+  return !samples.empty();
+}
+
+bool ProcessTaskSampler::sample(const std::vector<TaskId_t> &tids) {
+  beginSample();
+  if (taskDirFd_ < 0) return false;
+
+  for (auto tid : tids) {
+    char tidName[16];
+    snprintf(tidName, sizeof(tidName), "%u", tid);
+    readTask(tidName);
+  }
+  closeGoneTaskFiles();
+  return !samples.empty();
+}
+
+void ProcessTaskSampler::beginSample() {
+  ++sampleCount_;
+  if (backend == Backend::SCHEDSTAT) {
+    prevSamples_.swap(samples);
+    prevCursor_ = 0;
+    if (sampleCount_ % NameRefreshSamples == 0) prevSamples_.clear();
+  }
+  samples.clear();
+  timestampNs = std::chrono::duration_cast<std::chrono::nanoseconds>(std::chrono::steady_clock::now().time_since_epoch()).count();
+  readIo();
+}
+
+void ProcessTaskSampler::readIo() {
+  ioOk = false;
+  if (!ioFile_.isOpen()) return;
+  char buf[256];
+  auto len = ioFile_.read(buf, sizeof(buf));
+  if (len <= 0) return;
+
+  detail::ProcIo stat;  // NOLINT
+  if (!stat.parse(buf, buf + len)) return;
+  io.rchar = stat.rchar;
+  io.wchar = stat.wchar;
+  io.readBytes = stat.readBytes;
+  io.writeBytes = stat.writeBytes;
+  ioOk = true;
+}
+
+bool ProcessTaskSampler::readTask(const char *tidName) {
+  samples.emplace_back();
+  auto &sample = samples.back();
+  bool ok;
+  switch (backend) {
+    case Backend::TASKSTATS:
+      ok = readTaskStats(tidName, &sample);
+      // e.g. the capability was dropped after open(), the rest of the threads and samples are read from procfs
+      if (!ok && errno == EPERM) {
+        cpu_monitor_LOGW("taskstats query denied, fallback to procfs");
+        taskStats_ = nullptr;
+        backend = Backend::PROCFS;
+        ok = readProcfs(tidName, &sample);
+      }
+      break;
+    case Backend::SCHEDSTAT:
+      ok = readSchedStat(tidName, &sample);
+      break;
+    default:
+      ok = readProcfs(tidName, &sample);
+      break;
+  }
+  if (!ok) {
+    samples.pop_back();
+    return false;
+  }
+
+  if ((PID_t)sample.id == pid && name != sample.name) {
+    name = sample.name;
+  }
+  return true;
+}
+
+ssize_t ProcessTaskSampler::readTaskFile(const char *tidName, const char *fileName, detail::ProcFile TaskFile::*member, char *buf, size_t size) {
+  auto tid = (TaskId_t)strtoul(tidName, nullptr, 10);
+  auto &taskFile = taskFiles_[tid];
+  taskFile.sampleCount = sampleCount_;
+  auto &file = taskFile.*member;
+  if (file.isOpen()) {
+    auto len = file.read(buf, size);
+    if (len > 0) return len;
+    // ESRCH: the thread has exited, the tid may have been reused by the thread listed now
+    file.close();
+  }
+
+  char path[32];
+  snprintf(path, sizeof(path), "%s/%s", tidName, fileName);
+  ssize_t len = -1;
+  if (file.openAt(taskDirFd_, path)) len = file.read(buf, size);
+  if (len <= 0) taskFiles_.erase(tid);
+  return len;
+}
+
+bool ProcessTaskSampler::readCtxSwitches(const char *tidName, TaskSample *sample) {
+  // about 1.5KB, more with a long Cpus_allowed_list
+  char buf[4096];
+  auto len = readTaskFile(tidName, "status", &TaskFile::status, buf, sizeof(buf));
+  if (len <= 0) return false;
+
+  detail::TaskStatus status;  // NOLINT
+  if (!status.parse(buf, buf + len)) return false;
+  sample->ctxSwitches = status.volCtxSwitches + status.involCtxSwitches;
+  sample->involCtxSwitches = status.involCtxSwitches;
+  return true;
+}
+
+void ProcessTaskSampler::closeGoneTaskFiles() {
+  for (auto iter = taskFiles_.begin(); iter != taskFiles_.end();) {
+    if (iter->second.sampleCount != sampleCount_) {
+      iter = taskFiles_.erase(iter);
+    } else {
+      ++iter;
+    }
+  }
+}
+
+bool ProcessTaskSampler::readProcfs(const char *tidName, TaskSample *sample) {
+  char buf[1024];
+  auto len = readTaskFile(tidName, "stat", &TaskFile::file, buf, sizeof(buf));
+  if (len <= 0) return false;
+
+  detail::TaskStat stat;  // NOLINT
+  if (!stat.parse(buf, buf + len)) return false;
+
+  sample->id = stat.id;
+  memcpy(sample->name, stat.name, sizeof(sample->name));
+  sample->cpuTimeNs = stat.calcTicksTotal() * NsPerTick;
+  sample->cpuDelayNs = sample->blkioDelayNs = sample->swapinDelayNs = 0;
+  sample->minFlt = stat.min_flt;
+  sample->majFlt = stat.maj_flt;
+  return readCtxSwitches(tidName, sample);
+}
+
+bool ProcessTaskSampler::readTaskStats(const char *tidName, TaskSample *sample) {
+  detail::TaskStatsData data;  // NOLINT
+  auto tid = (TaskId_t)strtoul(tidName, nullptr, 10);
+  if (!taskStats_->query(tid, &data)) return false;
+
+  sample->id = tid;
+  memcpy(sample->name, data.comm, sizeof(data.comm));
+  sample->cpuTimeNs = data.cpuTimeNs;
+  sample->cpuDelayNs = data.cpuDelayNs;
+  sample->blkioDelayNs = data.blkioDelayNs;
+  sample->swapinDelayNs = data.swapinDelayNs;
+  sample->minFlt = data.minFlt;
+  sample->majFlt = data.majFlt;
+  sample->ctxSwitches = data.volCtxSwitches + data.involCtxSwitches;
+  sample->involCtxSwitches = data.involCtxSwitches;
+  return true;
+}
+
+bool ProcessTaskSampler::readSchedStat(const char *tidName, TaskSample *sample) {
+  char buf[96];
+  auto len = readTaskFile(tidName, "schedstat", &TaskFile::file, buf, sizeof(buf));
+  if (len <= 0) return false;
+
+  detail::SchedStat stat;  // NOLINT
+  if (!stat.parse(buf, buf + len)) return false;
+
+  auto tid = (TaskId_t)strtoul(tidName, nullptr, 10);
+  sample->id = tid;
+  sample->cpuTimeNs = stat.runNs;
+  sample->cpuDelayNs = stat.waitNs;
+  sample->blkioDelayNs = sample->swapinDelayNs = 0;
+  sample->minFlt = sample->majFlt = 0;
+  if (!readCtxSwitches(tidName, sample)) return false;
+
+  // getdents64 lists threads in a stable order, so the previous sample of the same thread is at or after the cursor
+  for (auto i = prevCursor_; i < prevSamples_.size(); ++i) {
+    if (prevSamples_[i].id == tid) {
+      memcpy(sample->name, prevSamples_[i].name, sizeof(sample->name));
+      prevCursor_ = i + 1;
+      return true;
+    }
+  }
+
+  char path[32];
+  snprintf(path, sizeof(path), "%s/comm", tidName);
+  detail::ProcFile file;
+  if (!file.openAt(taskDirFd_, path)) return false;
+  len = file.read(sample->name, sizeof(sample->name) - 1);
+  if (len <= 0) return false;
+  // comm ends with `\n`
+  if (sample->name[len - 1] == '\n') --len;
+  sample->name[len] = '\0';
+  return true;
+}
+
+}  // namespace cpu_monitor
@@ -0,0 +1,33 @@
+#pragma once
+
+#include <cstdint>
+
+#include "ProcParse.h"
+
+namespace cpu_monitor {
+namespace detail {
+
+/**
+ * /proc/<pid>/task/<tid>/schedstat
+ * like: 497776371 3170975 23
+ */
+struct SchedStat {
+  uint64_t runNs;       // time spent on the cpu
+  uint64_t waitNs;      // time spent waiting on a run queue
+  uint64_t timeslices;  // number of timeslices run on this cpu
+
+  /**
+   * @return false if the content is truncated or malformed
+   */
+  bool parse(const char *p, const char *end) {
+    using namespace ProcParse;
+    for (auto field : {&runNs, &waitNs, &timeslices}) {
+      p = parseU64(p, end, field);
+      if (p == nullptr) return false;
+    }
+    return true;
+  }
+};
+
+}  // namespace detail
+}  // namespace cpu_monitor
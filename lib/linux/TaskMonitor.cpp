@@ -1,73 +1,54 @@
 #include "TaskMonitor.h"
 
-#include <fstream>
+#include <cerrno>
+#include <cstdio>
 #include <iostream>
 
+#include "ProcessTaskSampler.h"
 #include "TaskStat.h"
 
-#define READ_PROP(name) file >> stat.name
-
 namespace cpu_monitor {
 
 TaskMonitor::TaskMonitor(TaskId_t tid, TaskMonitor::TotalTimeImpl cpuTicksImpl) : id(tid), totalTimeImpl_(std::move(cpuTicksImpl)) {
   update();
 }
 
+TaskMonitor::TaskMonitor(const TaskSample &sample)
+    : name(sample.name),
+      id(sample.id),
+      totalThreadTime_(sample.cpuTimeNs),
+      totalCpuDelay_(sample.cpuDelayNs),
+      totalBlkioDelay_(sample.blkioDelayNs),
+      totalSwapinDelay_(sample.swapinDelayNs) {}
+
 bool TaskMonitor::update() {
-  std::string path = "/proc/" + std::to_string(id) + "/task/" + std::to_string(id) + "/stat";
-  std::fstream file(path, std::fstream::in);
-  if (!file.is_open()) {
+  if (exited_) return false;
+
+  if (!statFile_.isOpen()) {
+    char path[64];
+    snprintf(path, sizeof(path), "/proc/%u/task/%u/stat", id, id);
+    if (!statFile_.open(path)) {
+      // ENOENT: the thread has exited, EMFILE/ENFILE: out of fds, try again next time
+      exited_ = errno == ENOENT || errno == ESRCH;
+      return false;
+    }
+  }
+
+  char buf[1024];
+  auto len = statFile_.read(buf, sizeof(buf));
+  if (len <= 0) {
+    // ESRCH: the thread has exited, even if its tid has been reused by another thread
+    exited_ = true;
+    statFile_.close();
+    return false;
+  }
+
+  detail::TaskStat stat;  // NOLINT
+  if (!stat.parse(buf, buf + len)) {
     return false;
   }
 
-  detail::TaskStat stat;
-  READ_PROP(id);
-  READ_PROP(name);
-  READ_PROP(task_state);
-  READ_PROP(ppid);
-  READ_PROP(pgid);
-  READ_PROP(sid);
-  READ_PROP(tty_nr);
-  READ_PROP(tty_pgrp);
-  READ_PROP(task_flags);
-  READ_PROP(min_flt);
-  READ_PROP(cmin_flt);
-  READ_PROP(maj_flt);
-  READ_PROP(cmaj_flt);
-  READ_PROP(utime);
-  READ_PROP(stime);
-  READ_PROP(cutime);
-  READ_PROP(cstime);
-  READ_PROP(priority);
-  READ_PROP(nice);
-  READ_PROP(num_threads);
-  READ_PROP(it_real_value);
-  READ_PROP(start_time);
-  READ_PROP(vsize);
-  READ_PROP(rss);
-  READ_PROP(rlim);
-  READ_PROP(start_code);
-  READ_PROP(end_code);
-  READ_PROP(start_stack);
-  READ_PROP(kstkesp);
-  READ_PROP(kstkeip);
-  READ_PROP(pendingsig);
-  READ_PROP(block_sig);
-  READ_PROP(sigign);
-  READ_PROP(sigcatch);
-  READ_PROP(wchan);
-  READ_PROP(nswap);
-  READ_PROP(cnswap);
-  READ_PROP(exit_signal);
-  READ_PROP(task_cpu);
-  READ_PROP(task_rt_priority);
-  READ_PROP(task_policy);
-
-  // linux thread name like: (cpu_monitor)
-  // remove the `()`
-  if (stat.name.size() >= 2 && stat.name[0] == '(') {
-    name = stat.name.substr(1, stat.name.size() - 2);
-  } else {
+  if (name != stat.name) {
     name = stat.name;
   }
 
@@ -84,6 +65,24 @@ bool TaskMonitor::update() {
   return true;
 }
 
+void TaskMonitor::update(const TaskSample &sample, uint64_t intervalNs) {
+  if (name != sample.name) {
+    name = sample.name;
+  }
+  usage = intervalNs ? (sample.cpuTimeNs - totalThreadTime_) * 100.f / intervalNs : 0;  // NOLINT
+  if (usage > 100) {                                                                    // invalid data
+    usage = 0;
+  }
+  totalThreadTime_ = sample.cpuTimeNs;
+
+  cpuDelayNs = sample.cpuDelayNs - totalCpuDelay_;
+  blkioDelayNs = sample.blkioDelayNs - totalBlkioDelay_;
+  swapinDelayNs = sample.swapinDelayNs - totalSwapinDelay_;
+  totalCpuDelay_ = sample.cpuDelayNs;
+  totalBlkioDelay_ = sample.blkioDelayNs;
+  totalSwapinDelay_ = sample.swapinDelayNs;
+}
+
 void TaskMonitor::dump() const {
   // clang-format off
   std::cout << ">> TaskMonitor dump: \n"
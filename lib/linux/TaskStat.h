@@ -1,22 +1,24 @@
 #pragma once
 
 #include <cstdint>
-#include <string>
+#include <cstring>
+
+#include "ProcParse.h"
 
 namespace cpu_monitor {
 namespace detail {
 
 struct TaskStat {
-  uint64_t id;       // 进程(包括轻量级进程，即线程)号
-  std::string name;  // 应用程序或命令的名字。
-  char task_state;   // 任务的状态
-                     // R:running
-                     // S:sleeping (TASK_INTERRUPTIBLE)
-                     // D:disk sleep (TASK_UNINTERRUPTIBLE)
-                     // T:stopped
-                     // T:tracing stop
-                     // Z:zombie
-                     // X:dead
+  uint64_t id;      // 进程(包括轻量级进程，即线程)号
+  char name[64];    // 应用程序或命令的名字。(已去除两侧的`()`)
+  char task_state;  // 任务的状态
+                    // R:running
+                    // S:sleeping (TASK_INTERRUPTIBLE)
+                    // D:disk sleep (TASK_UNINTERRUPTIBLE)
+                    // T:stopped
+                    // T:tracing stop
+                    // Z:zombie
+                    // X:dead
 
   uint64_t ppid,         // 父进程ID
       pgid,              // 线程组号
@@ -61,6 +63,43 @@ struct TaskStat {
   inline uint64_t calcTicksTotal() const {
     return utime + stime + cutime + cstime;
   }
+
+  /**
+   * parse the content of /proc/<pid>/task/<tid>/stat in one pass
+   * only `id`, `name`, `task_state` and `ppid`..`cstime` are filled, with `toRss` `priority`..`rss` too
+   * @return false if the content is truncated or malformed
+   */
+  bool parse(const char *p, const char *end, bool toRss = false) {
+    using namespace ProcParse;
+    p = parseU64(p, end, &id);
+    if (p == nullptr) return false;
+
+    // linux thread name like: (cpu_monitor)
+    // the name itself may contain spaces, `(` and `)`, so it ends at the last `)`
+    auto nameBegin = static_cast<const char *>(memchr(p, '(', end - p));
+    auto nameEnd = static_cast<const char *>(memrchr(p, ')', end - p));
+    if (nameBegin == nullptr || nameEnd == nullptr || nameEnd < nameBegin) return false;
+    ++nameBegin;
+    size_t nameLen = nameEnd - nameBegin;
+    if (nameLen >= sizeof(name)) nameLen = sizeof(name) - 1;
+    memcpy(name, nameBegin, nameLen);
+    name[nameLen] = '\0';
+
+    p = skipSpaces(nameEnd + 1, end);
+    if (p == end) return false;
+    task_state = *p++;
+
+    for (auto field : {&ppid, &pgid, &sid, &tty_nr, &tty_pgrp, &task_flags, &min_flt, &cmin_flt, &maj_flt, &cmaj_flt, &utime, &stime, &cutime, &cstime}) {
+      p = parseI64(p, end, field);
+      if (p == nullptr) return false;
+    }
+    if (!toRss) return true;
+    for (auto field : {&priority, &nice, &num_threads, &it_real_value, &start_time, &vsize, &rss}) {
+      p = parseI64(p, end, field);
+      if (p == nullptr) return false;
+    }
+    return true;
+  }
 };
 
 }  // namespace detail
@@ -0,0 +1,151 @@
+#include "TaskStatsClient.h"
+
+#include <linux/genetlink.h>
+#include <linux/netlink.h>
+#include <linux/taskstats.h>
+#include <sys/socket.h>
+#include <unistd.h>
+
+#include <algorithm>
+#include <cerrno>
+#include <cstring>
+
+namespace cpu_monitor {
+namespace detail {
+
+namespace {
+
+template <typename Func>
+void forEachAttr(const char *p, const char *end, Func &&func) {
+  while (p + NLA_HDRLEN <= end) {
+    auto attr = reinterpret_cast<const nlattr *>(p);
+    if (attr->nla_len < NLA_HDRLEN || p + attr->nla_len > end) break;
+    func(attr->nla_type & NLA_TYPE_MASK, p + NLA_HDRLEN, attr->nla_len - NLA_HDRLEN);
+    p += NLA_ALIGN(attr->nla_len);
+  }
+}
+
+}  // namespace
+
+TaskStatsClient::~TaskStatsClient() {
+  if (fd_ >= 0) close(fd_);
+}
+
+bool TaskStatsClient::open() {
+  fd_ = socket(AF_NETLINK, SOCK_RAW | SOCK_CLOEXEC, NETLINK_GENERIC);
+  if (fd_ < 0) return false;
+
+  sockaddr_nl addr{};
+  addr.nl_family = AF_NETLINK;
+  if (bind(fd_, reinterpret_cast<sockaddr *>(&addr), sizeof(addr)) < 0) return false;
+
+  // the kernel replies synchronously, the timeout only guards against a lost reply
+  timeval timeout{1, 0};
+  setsockopt(fd_, SOL_SOCKET, SO_RCVTIMEO, &timeout, sizeof(timeout));
+
+  const char familyName[] = TASKSTATS_GENL_NAME;
+  if (!send(GENL_ID_CTRL, CTRL_CMD_GETFAMILY, 1, CTRL_ATTR_FAMILY_NAME, familyName, sizeof(familyName))) return false;
+  auto len = recv();
+  if (len <= 0) return false;
+
+  auto nlh = reinterpret_cast<const nlmsghdr *>(buf_);
+  auto begin = static_cast<const char *>(NLMSG_DATA(nlh)) + GENL_HDRLEN;
+  auto end = buf_ + nlh->nlmsg_len;
+  forEachAttr(begin, end, [this](int type, const char *data, size_t) {
+    if (type == CTRL_ATTR_FAMILY_ID) memcpy(&familyId_, data, sizeof(familyId_));
+  });
+  if (familyId_ == 0) return false;
+
+  // the family is listed for everyone, but TASKSTATS_CMD_GET needs CAP_NET_ADMIN
+  TaskStatsData data;  // NOLINT
+  return query(getpid(), &data);
+}
+
+bool TaskStatsClient::query(TaskId_t tid, TaskStatsData *data) {
+  uint32_t pid = tid;
+  if (!send(familyId_, TASKSTATS_CMD_GET, TASKSTATS_GENL_VERSION, TASKSTATS_CMD_ATTR_PID, &pid, sizeof(pid))) return false;
+  auto len = recv();
+  if (len <= 0) return false;
+
+  taskstats stats{};
+  bool found = false;
+  auto nlh = reinterpret_cast<const nlmsghdr *>(buf_);
+  auto begin = static_cast<const char *>(NLMSG_DATA(nlh)) + GENL_HDRLEN;
+  auto end = buf_ + nlh->nlmsg_len;
+  forEachAttr(begin, end, [&](int type, const char *aggr, size_t aggrLen) {
+    if (type != TASKSTATS_TYPE_AGGR_PID) return;
+    forEachAttr(aggr, aggr + aggrLen, [&](int type, const char *payload, size_t payloadLen) {
+      if (type != TASKSTATS_TYPE_STATS) return;
+      // older kernels send a shorter struct
+      memcpy(&stats, payload, std::min(payloadLen, sizeof(stats)));
+      found = true;
+    });
+  });
+  if (!found) return false;
+
+  memcpy(data->comm, stats.ac_comm, sizeof(data->comm));
+  data->comm[sizeof(data->comm) - 1] = '\0';
+  data->cpuTimeNs = stats.cpu_run_virtual_total ? stats.cpu_run_virtual_total : (stats.ac_utime + stats.ac_stime) * 1000;
+  data->cpuDelayNs = stats.cpu_delay_total;
+  data->blkioDelayNs = stats.blkio_delay_total;
+  data->swapinDelayNs = stats.swapin_delay_total;
+  data->minFlt = stats.ac_minflt;
+  data->majFlt = stats.ac_majflt;
+  data->volCtxSwitches = stats.nvcsw;
+  data->involCtxSwitches = stats.nivcsw;
+  return true;
+}
+
+bool TaskStatsClient::send(uint16_t type, uint8_t cmd, uint8_t version, uint16_t attrType, const void *attr, uint16_t attrLen) {
+  char msg[NLMSG_SPACE(GENL_HDRLEN + NLA_HDRLEN + 64)]{};
+  if (NLA_ALIGN(attrLen) > 64) return false;
+
+  auto nlh = reinterpret_cast<nlmsghdr *>(msg);
+  nlh->nlmsg_len = NLMSG_LENGTH(GENL_HDRLEN + NLA_HDRLEN + NLA_ALIGN(attrLen));
+  nlh->nlmsg_type = type;
+  nlh->nlmsg_flags = NLM_F_REQUEST;
+  nlh->nlmsg_seq = ++seq_;
+  nlh->nlmsg_pid = 0;
+
+  auto genl = static_cast<genlmsghdr *>(NLMSG_DATA(nlh));
+  genl->cmd = cmd;
+  genl->version = version;
+
+  auto na = reinterpret_cast<nlattr *>(reinterpret_cast<char *>(genl) + GENL_HDRLEN);
+  na->nla_type = attrType;
+  na->nla_len = NLA_HDRLEN + attrLen;
+  memcpy(reinterpret_cast<char *>(na) + NLA_HDRLEN, attr, attrLen);
+
+  sockaddr_nl addr{};
+  addr.nl_family = AF_NETLINK;
+  ssize_t ret;
+  do {
+    ret = sendto(fd_, msg, nlh->nlmsg_len, 0, reinterpret_cast<sockaddr *>(&addr), sizeof(addr));
+  } while (ret < 0 && errno == EINTR);
+  return ret == (ssize_t)nlh->nlmsg_len;
+}
+
+ssize_t TaskStatsClient::recv() {
+  for (;;) {
+    auto len = ::recv(fd_, buf_, sizeof(buf_), 0);
+    if (len < 0 && errno == EINTR) continue;
+    if (len < 0) return len;
+
+    auto nlh = reinterpret_cast<const nlmsghdr *>(buf_);
+    if (!NLMSG_OK(nlh, (size_t)len)) {
+      errno = EBADMSG;
+      return -1;
+    }
+    // drop the reply of a request that timed out before
+    if (nlh->nlmsg_seq != seq_) continue;
+    if (nlh->nlmsg_type == NLMSG_ERROR) {
+      auto err = static_cast<const nlmsgerr *>(NLMSG_DATA(nlh));
+      errno = err->error ? -err->error : EINVAL;
+      return -1;
+    }
+    return len;
+  }
+}
+
+}  // namespace detail
+}  // namespace cpu_monitor
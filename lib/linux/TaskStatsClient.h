@@ -0,0 +1,56 @@
+#pragma once
+
+#include <sys/types.h>
+
+#include <cstdint>
+
+#include "Types.h"
+#include "detail/noncopyable.hpp"
+
+namespace cpu_monitor {
+namespace detail {
+
+struct TaskStatsData {
+  char comm[32];
+  uint64_t cpuTimeNs;      // precise on-cpu time when delay accounting is on, otherwise utime + stime in us resolution
+  uint64_t cpuDelayNs;     // time spent waiting on a run queue
+  uint64_t blkioDelayNs;   // time spent waiting for synchronous block io
+  uint64_t swapinDelayNs;  // time spent waiting for swapin
+  uint64_t minFlt;
+  uint64_t majFlt;
+  uint64_t volCtxSwitches;
+  uint64_t involCtxSwitches;
+};
+
+/**
+ * Query per task accounting by the generic netlink TASKSTATS family
+ * delays are only reported when delay accounting is enabled: `sysctl kernel.task_delayacct=1`
+ */
+class TaskStatsClient : noncopyable {
+ public:
+  ~TaskStatsClient();
+
+  /**
+   * open the netlink socket, resolve the TASKSTATS family id and query the calling process once
+   * @return false if the kernel does not support taskstats, or queries are denied (errno is EPERM without CAP_NET_ADMIN)
+   */
+  bool open();
+
+  /**
+   * @return false if the task does not exist (errno is ESRCH) or the query failed
+   */
+  bool query(TaskId_t tid, TaskStatsData *data);
+
+ private:
+  bool send(uint16_t type, uint8_t cmd, uint8_t version, uint16_t attrType, const void *attr, uint16_t attrLen);
+  ssize_t recv();
+
+ private:
+  int fd_ = -1;
+  uint16_t familyId_ = 0;
+  uint32_t seq_ = 0;
+  alignas(8) char buf_[2048];
+};
+
+}  // namespace detail
+}  // namespace cpu_monitor
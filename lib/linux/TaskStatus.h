@@ -0,0 +1,48 @@
+#pragma once
+
+#include <cstdint>
+#include <cstring>
+
+#include "ProcParse.h"
+
+namespace cpu_monitor {
+namespace detail {
+
+/**
+ * the context switches of /proc/<pid>/task/<tid>/status, the last lines of it
+ * like:
+ * voluntary_ctxt_switches:	150
+ * nonvoluntary_ctxt_switches:	545
+ */
+struct TaskStatus {
+  uint64_t volCtxSwitches;
+  uint64_t involCtxSwitches;
+
+  /**
+   * @return false if the content is truncated or has no context switches
+   */
+  bool parse(const char *p, const char *end) {
+    using namespace ProcParse;
+    static const char Vol[] = "voluntary_ctxt_switches:";
+    static const char Invol[] = "nonvoluntary_ctxt_switches:";
+    bool volFound = false;
+    bool involFound = false;
+    for (; p < end; p = nextLine(p, end)) {
+      if (startsWith(p, end, Vol)) {
+        volFound = parseU64(p + sizeof(Vol) - 1, end, &volCtxSwitches) != nullptr;
+      } else if (startsWith(p, end, Invol)) {
+        involFound = parseU64(p + sizeof(Invol) - 1, end, &involCtxSwitches) != nullptr;
+      }
+    }
+    return volFound && involFound;
+  }
+
+ private:
+  template <size_t N>
+  static bool startsWith(const char *p, const char *end, const char (&prefix)[N]) {
+    return (size_t)(end - p) >= N - 1 && memcmp(p, prefix, N - 1) == 0;
+  }
+};
+
+}  // namespace detail
+}  // namespace cpu_monitor
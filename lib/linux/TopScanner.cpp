@@ -0,0 +1,119 @@
+#include "TopScanner.h"
+
+#include <fcntl.h>
+#include <sys/syscall.h>
+#include <unistd.h>
+
+#include <cstdio>
+#include <cstring>
+
+#include "ProcParse.h"
+#include "TaskStat.h"
+#include "detail/defer.h"
+#include "detail/log.h"
+#include "detail/proc_file.h"
+
+namespace cpu_monitor {
+
+namespace {
+
+struct LinuxDirent64 {
+  uint64_t d_ino;
+  int64_t d_off;
+  unsigned short d_reclen;
+  unsigned char d_type;
+  char d_name[256];
+};
+
+const uint64_t NsPerTick = 1000000000ULL / sysconf(_SC_CLK_TCK);
+const uint64_t PageKB = sysconf(_SC_PAGESIZE) / 1024;
+
+/**
+ * call `func` with the name of every numeric entry of a directory
+ * @return false if the directory can not be read, e.g. the process has exited
+ */
+template <typename Func>
+bool forEachId(int dirFd, std::vector<char> &buf, Func &&func) {
+  if (lseek(dirFd, 0, SEEK_SET) < 0) return false;
+  for (;;) {
+    auto len = syscall(SYS_getdents64, dirFd, buf.data(), buf.size());
+    if (len < 0) return false;
+    if (len == 0) return true;
+
+    for (long pos = 0; pos < len;) {
+      auto dirent = reinterpret_cast<const LinuxDirent64 *>(buf.data() + pos);
+      pos += dirent->d_reclen;
+      if (detail::ProcParse::isDigit(dirent->d_name[0])) func(dirent->d_name);
+    }
+  }
+}
+
+/**
+ * read `<id>/stat` under `dirFd`
+ */
+bool readStat(int dirFd, const char *id, detail::ProcFile &file, bool toRss, detail::TaskStat *stat) {
+  char path[32];
+  auto idLen = strlen(id);
+  if (idLen + sizeof("/stat") > sizeof(path)) return false;
+  memcpy(path, id, idLen);
+  memcpy(path + idLen, "/stat", sizeof("/stat"));
+  if (!file.openAt(dirFd, path)) return false;
+  char buf[1024];
+  auto len = file.read(buf, sizeof(buf));
+  file.close();
+  return len > 0 && stat->parse(buf, buf + len, toRss);
+}
+
+}  // namespace
+
+TopScanner::TopScanner(size_t topN) : topN(topN) {
+  procFd_ = open("/proc", O_RDONLY | O_DIRECTORY | O_CLOEXEC);
+  if (procFd_ < 0) cpu_monitor_LOGE("open /proc failed: %s", strerror(errno));
+  buf_.resize(32 * 1024);
+}
+
+TopScanner::~TopScanner() {
+  if (procFd_ >= 0) close(procFd_);
+}
+
+bool TopScanner::listProcesses(std::vector<ProcessRecord> &records) {
+  records.clear();
+  if (procFd_ < 0) return false;
+  detail::ProcFile file;
+  detail::TaskStat stat;  // NOLINT
+  return forEachId(procFd_, buf_, [&](const char *pid) {
+    // the process may exit between getdents64 and reading it
+    if (!readStat(procFd_, pid, file, true, &stat)) return;
+    records.emplace_back();
+    auto &record = records.back();
+    record.pid = (PID_t)stat.id;
+    record.startTime = stat.start_time;
+    record.cpuTimeNs = (stat.utime + stat.stime) * NsPerTick;
+    record.rss = stat.rss * PageKB;
+    record.threads = (uint32_t)stat.num_threads;
+    memcpy(record.name, stat.name, sizeof(record.name));
+  });
+}
+
+bool TopScanner::listThreads(PID_t pid, std::vector<ThreadRecord> &records) {
+  char path[32];
+  snprintf(path, sizeof(path), "%d/task", pid);
+  int taskFd = openat(procFd_, path, O_RDONLY | O_DIRECTORY | O_CLOEXEC);
+  if (taskFd < 0) return false;
+  defer {
+    close(taskFd);
+  };
+
+  detail::ProcFile file;
+  detail::TaskStat stat;  // NOLINT
+  return forEachId(taskFd, buf_, [&](const char *tid) {
+    if (!readStat(taskFd, tid, file, false, &stat)) return;
+    records.emplace_back();
+    auto &record = records.back();
+    record.tid = (TaskId_t)stat.id;
+    record.cpuTimeNs = (stat.utime + stat.stime) * NsPerTick;
+    memcpy(record.name, stat.name, sizeof(record.name));
+  });
+}
+
+}  // namespace cpu_monitor
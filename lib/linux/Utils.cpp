@@ -2,12 +2,15 @@
 
 #include <dirent.h>
 
+#include <cstdio>
 #include <cstring>
-#include <fstream>
 #include <string>
 
+#include "ProcessIndex.h"
 #include "TaskMonitor.h"
+#include "TaskStat.h"
 #include "detail/defer.h"
+#include "detail/proc_file.h"
 
 namespace cpu_monitor {
 namespace Utils {
@@ -41,39 +44,27 @@ TasksRet getTasksOfPid(PID_t pid) {
 }
 
 PID_t getPidByName(const std::string& name) {
-  auto processName = name.size() > 16 ? name.substr(0, 15) : name;
+  // truncated like the kernel does, see ProcessIndex::Field::COMM
+  auto comm = name.substr(0, ProcessIndex::CommMaxLen);
 
-  DIR* dir = opendir("/proc");
+  auto dir = opendir("/proc");
+  if (dir == nullptr) return 0;
   defer {
-    if (!dir) return;
     closedir(dir);
   };
-  if (dir == nullptr) {
-    return 0;
-  }
-
-  struct dirent* ptr;
-  while ((ptr = readdir(dir)) != nullptr) {
-    if ((strcmp(ptr->d_name, ".") == 0) || (strcmp(ptr->d_name, "..") == 0)) continue;
-    if (DT_DIR != ptr->d_type) continue;
-
-    const auto& pidName = ptr->d_name;
-
-    std::string filePath = "/proc/" + std::string(pidName) + "/status";
-    std::fstream file(filePath, std::fstream::in);
-    if (!file.is_open()) {
-      continue;
-    }
-
-    // Name: xxxx
-    std::string tmpName;
-    file >> tmpName;
-    file >> tmpName;
-    file.close();
 
-    if (tmpName == processName) {
-      return (int)std::strtol(pidName, nullptr, 10);
-    }
+  // only <pid>/stat is read, /proc lists the pids in ascending order
+  char path[32];
+  char buf[1024];
+  detail::ProcFile file;
+  detail::TaskStat stat;  // NOLINT
+  while (auto p = readdir(dir)) {
+    if (!detail::ProcParse::isDigit(p->d_name[0])) continue;
+    snprintf(path, sizeof(path), "/proc/%s/stat", p->d_name);
+    if (!file.open(path)) continue;
+    auto len = file.read(buf, sizeof(buf));
+    if (len <= 0 || !stat.parse(buf, buf + len)) continue;
+    if (comm == stat.name) return (PID_t)std::strtol(p->d_name, nullptr, 10);
   }
   return 0;
 }
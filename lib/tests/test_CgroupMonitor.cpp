@@ -0,0 +1,70 @@
+#include <sys/stat.h>
+#include <unistd.h>
+
+#include <cerrno>
+#include <cinttypes>
+#include <cstring>
+#include <ctime>
+
+#include "CgroupMonitor.h"
+#include "assert_def.h"
+#include "detail/log.h"
+
+using namespace cpu_monitor;
+
+static void busy(int ms) {
+  auto end = clock() + (clock_t)ms * CLOCKS_PER_SEC / 1000;
+  while (clock() < end) {
+  }
+}
+
+int main(int argc, char** argv) {
+  auto root = CgroupMonitor::root();
+  if (root.empty()) {
+    cpu_monitor_LOGW("cgroup v2 not mounted");
+    return 0;
+  }
+  auto path = CgroupMonitor::pathOfPid(getpid());
+  cpu_monitor_LOGI("root: %s, self: %s", root.c_str(), path.c_str());
+  ASSERT(!path.empty() && path.front() == '/');
+
+  cpu_monitor_LOGI("=> sample");
+  CgroupMonitor monitor(path);
+  CgroupMonitor::Sample first;  // NOLINT
+  ASSERT(monitor.sample(&first));
+  busy(50);
+  CgroupMonitor::Sample second;  // NOLINT
+  ASSERT(monitor.sample(&second));
+  cpu_monitor_LOGI("usage:%" PRIu64 " user:%" PRIu64 " system:%" PRIu64 " throttled:%" PRIu64 "/%" PRIu64 " %" PRIu64 "us", second.usageUsec,
+                   second.userUsec, second.systemUsec, second.nrThrottled, second.nrPeriods, second.throttledUsec);
+  cpu_monitor_LOGI("quota:%" PRIu64 "/%" PRIu64 " memory:%" PRIu64 "/%" PRIu64 " anon:%" PRIu64 " file:%" PRIu64 " oom_kill:%" PRIu64,
+                   second.quotaUsec, second.periodUsec, second.memCurrent, second.memMax, second.anon, second.file, second.oomKills);
+  ASSERT(second.usageUsec > first.usageUsec);
+  ASSERT(second.userUsec + second.systemUsec <= second.usageUsec + 1000);
+  ASSERT(second.nrThrottled <= second.nrPeriods);
+
+  cpu_monitor_LOGI("=> absolute path");
+  CgroupMonitor absolute(root + path);
+  CgroupMonitor::Sample sample;  // NOLINT
+  ASSERT(absolute.sample(&sample));
+  ASSERT(sample.usageUsec >= second.usageUsec);
+
+  cpu_monitor_LOGI("=> not exist");
+  CgroupMonitor notExist("/cpu_monitor_not_exist");
+  ASSERT(!notExist.sample(&sample));
+
+  cpu_monitor_LOGI("=> removed");
+  auto child = "/cpu_monitor_test_" + std::to_string(getpid());
+  if (mkdir((root + child).c_str(), 0755) == 0) {
+    CgroupMonitor removed(child);
+    ASSERT(removed.sample(&sample));
+    ASSERT(sample.usageUsec == 0);
+    ASSERT(rmdir((root + child).c_str()) == 0);
+    ASSERT(!removed.sample(&sample));
+  } else {
+    cpu_monitor_LOGW("mkdir %s failed: %s", child.c_str(), strerror(errno));
+  }
+
+  cpu_monitor_LOGI("all tests passed");
+  return 0;
+}
@@ -0,0 +1,55 @@
+#include <cmath>
+#include <cstdint>
+
+#include "CpuTable.h"
+#include "assert_def.h"
+#include "detail/log.h"
+
+using namespace cpu_monitor;
+
+static void setTicks(CpuTable& table, size_t row, uint64_t user, uint64_t idle, uint64_t iowait) {
+  uint64_t ticks[CpuT::TYPE_NUM]{};
+  ticks[CpuT::USER] = user;
+  ticks[CpuT::IDLE] = idle;
+  ticks[CpuT::IOWAIT] = iowait;
+  table.setTicks(row, ticks);
+}
+
+int main() {
+  CpuTable table(3);
+  setTicks(table, 0, 100, 100, 0);
+  setTicks(table, 1, 200, 200, 0);
+  setTicks(table, 2, 300, 300, 0);
+  table.update();
+
+  // row 0: 3/4 busy, row 1: idle + iowait only, row 2: no tick
+  setTicks(table, 0, 130, 110, 0);
+  setTicks(table, 1, 200, 210, 10);
+  setTicks(table, 2, 300, 300, 0);
+  table.update();
+  ASSERT(std::fabs(table.usage(0) - 75.f) < 0.01f);
+  ASSERT(table.totalTime(0) == 40 && table.idleTime(0) == 10);
+  ASSERT(table.usage(1) == 0.f);
+  ASSERT(table.totalTime(1) == 20 && table.idleTime(1) == 20);
+  ASSERT(table.usage(2) == 0.f && table.totalTime(2) == 0);
+  ASSERT(std::fabs(table.time(0, CpuT::USER) - 75.f) < 0.01f && std::fabs(table.time(0, CpuT::IDLE) - 25.f) < 0.01f);
+  ASSERT(std::fabs(table.time(1, CpuT::IOWAIT) - 50.f) < 0.01f && table.time(1, CpuT::USER) == 0.f);
+  ASSERT(table.time(2, CpuT::USER) == 0.f && table.time(2, CpuT::IDLE) == 0.f);
+
+  // only the first row is updated, the others keep their results
+  setTicks(table, 0, 150, 110, 0);
+  table.update(1);
+  ASSERT(table.usage(0) == 100.f);
+  ASSERT(table.totalTime(1) == 20);
+
+  // growing keeps the existing rows
+  table.resize(4);
+  setTicks(table, 0, 160, 120, 0);
+  setTicks(table, 3, 10, 10, 0);
+  table.update();
+  ASSERT(std::fabs(table.usage(0) - 50.f) < 0.01f);
+  ASSERT(table.totalTime(3) == 20);
+
+  cpu_monitor_LOGI("all tests passed");
+  return 0;
+}
@@ -0,0 +1,100 @@
+#include <cmath>
+#include <cstdio>
+#include <string>
+#include <vector>
+
+#include "CpuMonitorCore.h"
+#include "CpuTable.h"
+#include "assert_def.h"
+#include "detail/log.h"
+#include "linux/CpuStat.h"
+
+using namespace cpu_monitor;
+
+static const uint64_t Wrap32 = 1ULL << 32;
+
+struct Step {
+  uint64_t user, system, idle, iowait;
+  float usage;       // expected
+  uint64_t total;    // expected ticks of the interval
+  float iowaitTime;  // expected percentage
+};
+
+// the `cpu` line and one core with the same ticks, as in /proc/stat
+static std::string makeProcStat(const Step& s) {
+  std::string text;
+  char line[256];
+  for (const char* name : {"cpu ", "cpu0"}) {
+    snprintf(line, sizeof(line), "%s %llu 0 %llu %llu %llu 0 0 0 0 0\n", name, (unsigned long long)s.user, (unsigned long long)s.system,
+             (unsigned long long)s.idle, (unsigned long long)s.iowait);
+    text += line;
+  }
+  text += "ctxt 256931\n";
+  return text;
+}
+
+static bool near(float a, float b) {
+  return std::fabs(a - b) < 0.01f;
+}
+
+int main() {
+  // clang-format off
+  const std::vector<Step> steps = {
+      // the first sample counts from boot
+      {Wrap32 - 60, 100, Wrap32 - 40, 100, 0, 0, 0},
+      // user and idle pass 2^32, the total is far beyond it
+      {Wrap32 - 30, 110, Wrap32 + 20, 120, 33.33f, 120, 16.67f},
+      {Wrap32 + 90, 130, Wrap32 + 80, 120, 70.f, 200, 0},
+      // iowait steps back by 1: counted as 0
+      {Wrap32 + 140, 130, Wrap32 + 130, 119, 50.f, 100, 0},
+      // all counters restart, e.g. after suspend
+      {10, 5, 20, 1, 0, 0, 0},
+      {30, 15, 40, 11, 50.f, 60, 16.67f},
+      // a 32-bit delta that is not a wrap: 2^31 - 1 user ticks
+      {30 + (1ULL << 31) - 1, 15, 40, 11, 100.f, (1ULL << 31) - 1, 0},
+  };
+  // clang-format on
+
+  // CpuMonitorCore: fscanf
+  {
+    CpuMonitorCore core;
+    for (size_t i = 0; i < steps.size(); ++i) {
+      auto text = makeProcStat(steps[i]);
+      FILE* fp = fmemopen(&text[0], text.size(), "r");
+      core.update(fp);
+      fclose(fp);
+      if (i == 0) continue;
+      cpu_monitor_LOGI("core step %zu: usage: %.2f, total: %" PRIu64, i, core.usage, core.totalTime);
+      ASSERT(near(core.usage, steps[i].usage));
+      ASSERT(core.totalTime == steps[i].total);
+      ASSERT(near(core.times[CpuT::IOWAIT], steps[i].iowaitTime));
+    }
+  }
+
+  // CpuTable: parse in place
+  {
+    CpuTable table(2);
+    for (size_t i = 0; i < steps.size(); ++i) {
+      auto text = makeProcStat(steps[i]);
+      const char* p = text.data();
+      const char* end = p + text.size();
+      detail::CpuStat stat;  // NOLINT
+      for (size_t row = 0; row < 2; ++row) {
+        p = stat.parse(p, end);
+        ASSERT(p != nullptr);
+        table.setTicks(row, stat.ticks);
+      }
+      table.update();
+      if (i == 0) continue;
+      for (size_t row = 0; row < 2; ++row) {
+        cpu_monitor_LOGI("table step %zu row %zu: usage: %.2f, total: %" PRIu64, i, row, table.usage(row), table.totalTime(row));
+        ASSERT(near(table.usage(row), steps[i].usage));
+        ASSERT(table.totalTime(row) == steps[i].total);
+        ASSERT(near(table.time(row, CpuT::IOWAIT), steps[i].iowaitTime));
+      }
+    }
+  }
+
+  cpu_monitor_LOGI("all tests passed");
+  return 0;
+}
@@ -17,5 +17,29 @@ int main(int argc, char** argv) {
   cpu_monitor_LOGI("VmSize:%lu", ret.usage.VmSize);
   cpu_monitor_LOGI("VmHWM:%lu", ret.usage.VmHWM);
   cpu_monitor_LOGI("VmRSS:%lu", ret.usage.VmRSS);
+  ASSERT(ret.ok && ret.usage.VmRSS > 0 && ret.usage.VmHWM >= ret.usage.VmRSS);
+
+  cpu_monitor_LOGI("=> sampleStatm");
+  MemMonitor monitor;
+  MemMonitor::Statm statm;  // NOLINT
+  ASSERT(monitor.sampleStatm(&statm));
+  cpu_monitor_LOGI("VmSize:%zu VmRSS:%zu shared:%zu text:%zu data:%zu", statm.VmSize, statm.VmRSS, statm.shared, statm.text, statm.data);
+  ASSERT(statm.VmSize == ret.usage.VmSize);
+  ASSERT(statm.VmRSS > 0 && statm.shared <= statm.VmRSS);
+
+  cpu_monitor_LOGI("=> sampleRollup");
+  MemMonitor::Rollup rollup;  // NOLINT
+  if (monitor.sampleRollup(&rollup)) {
+    cpu_monitor_LOGI("Pss:%zu Uss:%zu RssAnon:%zu RssFile:%zu RssShmem:%zu Swap:%zu", rollup.Pss, rollup.Uss, rollup.RssAnon, rollup.RssFile,
+                     rollup.RssShmem, rollup.Swap);
+    ASSERT(rollup.Pss > 0 && rollup.Uss <= rollup.Pss);
+    ASSERT(rollup.RssAnon + rollup.RssFile + rollup.RssShmem > 0);
+  } else {
+    cpu_monitor_LOGW("smaps_rollup not available");
+  }
+
+  MemMonitor exited(0x7ffffff0);
+  ASSERT(!exited.sampleStatm(&statm));
+  ASSERT(!exited.sampleRollup(&rollup));
   return 0;
 }
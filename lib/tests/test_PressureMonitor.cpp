@@ -0,0 +1,93 @@
+#include <sys/stat.h>
+#include <unistd.h>
+
+#include <cerrno>
+#include <cinttypes>
+#include <cstring>
+
+#include "CgroupMonitor.h"
+#include "PressureMonitor.h"
+#include "assert_def.h"
+#include "detail/log.h"
+
+using namespace cpu_monitor;
+
+using Resource = PressureMonitor::Resource;
+
+int main(int argc, char** argv) {
+  cpu_monitor_LOGI("=> name and parse");
+  for (auto resource : {Resource::CPU, Resource::MEMORY, Resource::IO}) {
+    Resource parsed;
+    ASSERT(PressureMonitor::parse(PressureMonitor::name(resource), &parsed) && parsed == resource);
+  }
+  Resource parsed;
+  ASSERT(!PressureMonitor::parse("gpu", &parsed));
+
+  cpu_monitor_LOGI("=> sample the system");
+  PressureMonitor::Sample sample;  // NOLINT
+  if (!PressureMonitor(Resource::CPU).sample(&sample)) {
+    cpu_monitor_LOGW("psi not available: %s", strerror(errno));
+    return 0;
+  }
+  for (auto resource : {Resource::CPU, Resource::MEMORY, Resource::IO}) {
+    PressureMonitor monitor(resource);
+    ASSERT(monitor.sample(&sample));
+    cpu_monitor_LOGI("%s some: %.2f %.2f %.2f %" PRIu64 ", full: %.2f %.2f %.2f %" PRIu64, PressureMonitor::name(resource), sample.some.avg10,
+                     sample.some.avg60, sample.some.avg300, sample.some.totalUsec, sample.full.avg10, sample.full.avg60, sample.full.avg300,
+                     sample.full.totalUsec);
+    ASSERT(sample.some.avg10 <= 100 && sample.some.avg60 <= 100 && sample.some.avg300 <= 100);
+    ASSERT(sample.full.totalUsec <= sample.some.totalUsec);
+    auto total = sample.some.totalUsec;
+    ASSERT(monitor.sample(&sample));
+    ASSERT(sample.some.totalUsec >= total);
+  }
+
+  cpu_monitor_LOGI("=> system triggers");
+  {
+    PressureTrigger trigger;
+    if (trigger.open(Resource::CPU, {}, false, 100 * 1000, 2000 * 1000)) {
+      ASSERT(trigger.fd() >= 0 && trigger.alive());
+      // the stall must be within the window
+      ASSERT(!trigger.open(Resource::CPU, {}, false, 3000 * 1000, 2000 * 1000) && errno == EINVAL);
+      ASSERT(trigger.fd() < 0 && !trigger.alive());
+    } else {
+      cpu_monitor_LOGW("psi triggers not available: %s", strerror(errno));
+    }
+  }
+
+  auto root = CgroupMonitor::root();
+  if (root.empty()) {
+    cpu_monitor_LOGW("cgroup v2 not mounted");
+    cpu_monitor_LOGI("all tests passed");
+    return 0;
+  }
+
+  cpu_monitor_LOGI("=> cgroups");
+  {
+    auto path = CgroupMonitor::pathOfPid(getpid());
+    PressureMonitor monitor(Resource::MEMORY, path);
+    if (monitor.sample(&sample)) {
+      cpu_monitor_LOGI("%s memory some: %.2f %" PRIu64, path.c_str(), sample.some.avg10, sample.some.totalUsec);
+    } else {
+      cpu_monitor_LOGW("psi of cgroups not available: %s", strerror(errno));
+    }
+    ASSERT(!PressureMonitor(Resource::CPU, "/cpu_monitor_not_exist").sample(&sample));
+
+    auto child = "/cpu_monitor_test_" + std::to_string(getpid());
+    if (mkdir((root + child).c_str(), 0755) == 0) {
+      PressureMonitor removed(Resource::CPU, child);
+      ASSERT(removed.sample(&sample));
+      ASSERT(sample.some.totalUsec == 0);
+      PressureTrigger trigger;
+      bool triggerOk = trigger.open(Resource::CPU, child, false, 100 * 1000, 2000 * 1000);
+      ASSERT(rmdir((root + child).c_str()) == 0);
+      ASSERT(!removed.sample(&sample));
+      if (triggerOk) ASSERT(!trigger.alive());
+    } else {
+      cpu_monitor_LOGW("mkdir %s failed: %s", child.c_str(), strerror(errno));
+    }
+  }
+
+  cpu_monitor_LOGI("all tests passed");
+  return 0;
+}
@@ -0,0 +1,46 @@
+#include <poll.h>
+#include <sys/syscall.h>
+#include <unistd.h>
+
+#include <atomic>
+#include <cstring>
+#include <thread>
+
+#include "ProcEvents.h"
+#include "assert_def.h"
+#include "detail/log.h"
+
+using namespace cpu_monitor;
+
+int main() {
+  ProcEvents procEvents;
+  if (!procEvents.open()) {
+    // may need CAP_NET_ADMIN
+    cpu_monitor_LOGW("proc events not available: %s", strerror(errno));
+    return 0;
+  }
+
+  // a short lived thread, it is never seen by polling /proc
+  std::atomic<TaskId_t> workerTid{0};
+  std::thread([&] {
+    workerTid = (TaskId_t)syscall(SYS_gettid);
+  }).join();
+  cpu_monitor_LOGI("worker tid: %u", workerTid.load());
+
+  bool forkFound = false;
+  bool exitFound = false;
+  std::vector<ProcEvent> events;
+  pollfd pfd{procEvents.fd(), POLLIN, 0};
+  while (!(forkFound && exitFound) && poll(&pfd, 1, 1000) > 0) {
+    events.clear();
+    procEvents.read(events);
+    for (const auto& event : events) {
+      if (event.pid != getpid() || event.tid != workerTid) continue;
+      forkFound |= event.type == ProcEvent::Type::FORK;
+      exitFound |= event.type == ProcEvent::Type::EXIT;
+    }
+  }
+  ASSERT(forkFound);
+  ASSERT(exitFound);
+  return 0;
+}
@@ -0,0 +1,134 @@
+#include <signal.h>
+#include <sys/prctl.h>
+#include <sys/wait.h>
+#include <unistd.h>
+
+#include <algorithm>
+
+#include "ProcEvents.h"
+#include "ProcessIndex.h"
+#include "assert_def.h"
+#include "detail/log.h"
+
+using namespace cpu_monitor;
+
+static bool contains(const std::vector<PID_t>& pids, PID_t pid) {
+  return std::find(pids.cbegin(), pids.cend(), pid) != pids.cend();
+}
+
+int main(int argc, char** argv) {
+  std::string name(argv[0]);
+  name = name.substr(name.rfind('/') + 1);
+  auto self = getpid();
+
+  cpu_monitor_LOGI("=> Query::parse");
+  {
+    auto query = ProcessIndex::Query::parse("nginx");
+    ASSERT(query.field == ProcessIndex::Field::COMM && query.pattern == "nginx");
+    query = ProcessIndex::Query::parse("exe:nginx");
+    ASSERT(query.field == ProcessIndex::Field::EXE && query.pattern == "nginx");
+    query = ProcessIndex::Query::parse("cmdline:nginx: worker");
+    ASSERT(query.field == ProcessIndex::Field::CMDLINE && query.pattern == "nginx: worker");
+  }
+
+  // instances of the same program
+  std::vector<PID_t> children;
+  for (int i = 0; i < 3; ++i) {
+    auto pid = fork();
+    if (pid == 0) {
+      // killed by the test, or by the alarm if the test aborts
+      alarm(30);
+      pause();
+      _exit(0);
+    }
+    children.push_back(pid);
+  }
+
+  ProcessIndex index;
+  ASSERT(index.update());
+  cpu_monitor_LOGI("processes: %zu", index.size());
+
+  cpu_monitor_LOGI("=> find all instances");
+  {
+    for (auto query : {"comm:" + name, "exe:" + name, "cmdline:" + name + "$", "cmdline:" + name}) {
+      auto pids = index.find(ProcessIndex::Query::parse(query));
+      cpu_monitor_LOGI("%s: %zu", query.c_str(), pids.size());
+      ASSERT(std::is_sorted(pids.cbegin(), pids.cend()));
+      ASSERT(contains(pids, self));
+      for (auto pid : children) {
+        ASSERT(contains(pids, pid));
+      }
+    }
+    // comm is truncated by the kernel
+    auto pids = index.find(ProcessIndex::Query::parse(name + "_with_a_long_suffix"));
+    ASSERT(contains(pids, self) == (name.size() >= ProcessIndex::CommMaxLen));
+    ASSERT(index.find(ProcessIndex::Query::parse("cmdline:(")).empty());
+  }
+
+  cpu_monitor_LOGI("=> parents and descendants");
+  {
+    ASSERT(contains(index.updated(), self));
+    ASSERT(index.parent(self) == getppid());
+    auto descendants = index.descendants({self});
+    ASSERT(descendants == children);
+    ASSERT(contains(index.descendants({getppid()}), children.front()));
+
+    auto pids = index.find(ProcessIndex::Matcher(ProcessIndex::Query::parse("cmdline:" + name)), {children.front(), 1});
+    ASSERT(pids.size() == 1 && pids.front() == children.front());
+    ASSERT(!ProcessIndex::Matcher(ProcessIndex::Query::parse("cmdline:(")).valid());
+  }
+
+  cpu_monitor_LOGI("=> exited processes are dropped");
+  {
+    for (auto pid : children) {
+      kill(pid, SIGKILL);
+      waitpid(pid, nullptr, 0);
+    }
+    ASSERT(index.update());
+    ASSERT(index.updated().empty());
+    ASSERT(index.descendants({self}).empty());
+    auto pids = index.find(ProcessIndex::Query::parse(name));
+    ASSERT(contains(pids, self));
+    for (auto pid : children) {
+      ASSERT(!contains(pids, pid));
+    }
+  }
+
+  cpu_monitor_LOGI("=> kept by events");
+  {
+    ProcEvent event{ProcEvent::Type::EXIT, self, (TaskId_t)self, 0, 0};
+    index.onEvent(event);
+    ASSERT(index.update(false));
+    ASSERT(!contains(index.find(ProcessIndex::Query::parse(name)), self));
+
+    event.type = ProcEvent::Type::FORK;
+    index.onEvent(event);
+    ASSERT(index.update(false));
+    ASSERT(contains(index.find(ProcessIndex::Query::parse(name)), self));
+
+    event.type = ProcEvent::Type::EXEC;
+    index.onEvent(event);
+    ASSERT(index.update(false));
+    ASSERT(contains(index.find(ProcessIndex::Query::parse(name)), self));
+
+    index.invalidate();
+    ASSERT(index.update(false));
+    ASSERT(contains(index.find(ProcessIndex::Query::parse(name)), self));
+  }
+
+  cpu_monitor_LOGI("=> comm and exe are not regexes");
+  {
+    prctl(PR_SET_NAME, "ab(c");
+    index.invalidate();
+    ASSERT(index.update());
+    auto pids = index.find(ProcessIndex::Query::parse("ab(c"));
+    ASSERT(contains(pids, self));
+    ProcessIndex::Matcher matcher(ProcessIndex::Query::parse("comm:ab(c"));
+    ASSERT(matcher.valid());
+    ASSERT(index.find(matcher, {self}) == std::vector<PID_t>{self});
+    prctl(PR_SET_NAME, name.substr(0, ProcessIndex::CommMaxLen).c_str());
+  }
+
+  cpu_monitor_LOGI("all tests passed");
+  return 0;
+}
@@ -0,0 +1,103 @@
+#include <pthread.h>
+#include <unistd.h>
+
+#include <atomic>
+#include <cinttypes>
+#include <cstring>
+#include <thread>
+#include <vector>
+
+#include "ProcessTaskSampler.h"
+#include "assert_def.h"
+#include "detail/log.h"
+
+using namespace cpu_monitor;
+
+int main() {
+  std::atomic<bool> stop{false};
+  std::thread worker([&] {
+    while (!stop) {
+    }
+  });
+  pthread_setname_np(worker.native_handle(), "busy worker");
+
+  ProcessTaskSampler sampler(getpid());
+  ASSERT(sampler.sample());
+  cpu_monitor_LOGI("process name: %s, threads: %zu", sampler.name.c_str(), sampler.samples.size());
+  ASSERT(sampler.samples.size() >= 2);
+
+  ASSERT(sampler.ioOk);
+  // faults of touching new pages, counted for the main thread
+  std::vector<char> pages(64 * 4096);
+  for (size_t i = 0; i < pages.size(); i += 4096) pages[i] = 1;
+
+  auto lastTimestampNs = sampler.timestampNs;
+  auto lastSamples = sampler.samples;
+  auto lastIo = sampler.io;
+  sleep(1);
+  ASSERT(sampler.sample());
+  ASSERT(sampler.ioOk && sampler.io.rchar >= lastIo.rchar);
+  ASSERT(sampler.samples[0].id == (TaskId_t)getpid() && sampler.samples[0].minFlt >= lastSamples[0].minFlt + 64);
+  // the default backend reports context switches too, sleep(1) is a voluntary one
+  ASSERT(sampler.samples[0].ctxSwitches > lastSamples[0].ctxSwitches);
+  ASSERT(sampler.samples[0].involCtxSwitches >= lastSamples[0].involCtxSwitches);
+  ASSERT(sampler.samples[0].involCtxSwitches <= sampler.samples[0].ctxSwitches);
+  auto intervalNs = sampler.timestampNs - lastTimestampNs;
+  for (const auto& sample : sampler.samples) {
+    for (const auto& last : lastSamples) {
+      if (last.id != sample.id) continue;
+      cpu_monitor_LOGI("name: %s, id: %u, usage: %.2f%%, cs/invol: %" PRIu64 "/%" PRIu64, sample.name, sample.id,
+                       (sample.cpuTimeNs - last.cpuTimeNs) * 100.f / intervalNs, sample.ctxSwitches - last.ctxSwitches,
+                       sample.involCtxSwitches - last.involCtxSwitches);
+    }
+  }
+
+  ProcessTaskSampler taskStats(getpid(), ProcessTaskSampler::Backend::TASKSTATS);
+  // without CAP_NET_ADMIN the queries are denied, and the threads are sampled by procfs instead
+  cpu_monitor_LOGI("taskstats available: %d", taskStats.backend == ProcessTaskSampler::Backend::TASKSTATS);
+  ASSERT(taskStats.sample());
+  ASSERT(taskStats.samples.size() == sampler.samples.size());
+  for (const auto& sample : taskStats.samples) {
+    cpu_monitor_LOGI("name: %s, id: %u, cpu: %" PRIu64 "ns, cpu delay: %" PRIu64 "ns", sample.name, sample.id, sample.cpuTimeNs, sample.cpuDelayNs);
+  }
+
+  ProcessTaskSampler schedStat(getpid(), ProcessTaskSampler::Backend::SCHEDSTAT);
+  cpu_monitor_LOGI("schedstat available: %d", schedStat.backend == ProcessTaskSampler::Backend::SCHEDSTAT);
+  ASSERT(schedStat.sample());
+  lastTimestampNs = schedStat.timestampNs;
+  lastSamples = schedStat.samples;
+  usleep(50 * 1000);
+  // names of known threads come from the previous sample
+  ASSERT(schedStat.sample());
+  ASSERT(schedStat.samples.size() == sampler.samples.size());
+  intervalNs = schedStat.timestampNs - lastTimestampNs;
+  bool workerFound = false;
+  for (const auto& sample : schedStat.samples) {
+    for (const auto& last : lastSamples) {
+      if (last.id != sample.id) continue;
+      ASSERT(strcmp(last.name, sample.name) == 0);
+      ASSERT(sample.ctxSwitches >= last.ctxSwitches && sample.involCtxSwitches >= last.involCtxSwitches);
+      cpu_monitor_LOGI("name: %s, id: %u, usage: %.2f%%, run queue latency: %" PRIu64 "ns", sample.name, sample.id,
+                       (sample.cpuTimeNs - last.cpuTimeNs) * 100.f / intervalNs, sample.cpuDelayNs - last.cpuDelayNs);
+    }
+    if (strcmp(sample.name, "busy worker") == 0) {
+      workerFound = true;
+      // a 50ms interval is far below the resolution of clock ticks
+      ASSERT(sample.cpuTimeNs > 0);
+    }
+  }
+  ASSERT(workerFound);
+
+  stop = true;
+  worker.join();
+
+  // the worker is no longer listed, its cached stat file is closed
+  ASSERT(sampler.sample());
+  ASSERT(sampler.samples.size() == 1);
+  ASSERT(schedStat.sample());
+  ASSERT(schedStat.samples.size() == 1);
+
+  ProcessTaskSampler notExist(-1);
+  ASSERT(!notExist.sample());
+  return 0;
+}
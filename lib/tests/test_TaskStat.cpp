@@ -0,0 +1,104 @@
+#include <cstring>
+#include <string>
+
+#include "assert_def.h"
+#include "detail/log.h"
+#include "linux/TaskStat.h"
+
+using namespace cpu_monitor;
+
+struct Fixture {
+  const char* comm;  // thread name as set by prctl(PR_SET_NAME), up to 15 bytes, or a long kernel worker name
+  char state;
+};
+
+// every fixture is rendered into the same stat line, only the comm differs
+static const Fixture fixtures[] = {
+    {"cpu_monitor", 'S'},
+    {"Worker Pool 3", 'R'},
+    {"(Worker Pool 3)", 'S'},
+    {"a) b", 'S'},
+    {") R 1 2 3 4 5", 'D'},
+    {")", 'S'},
+    {"(", 'S'},
+    {"((x))", 'T'},
+    {"", 'S'},
+    {" ", 'S'},
+    {"a  b", 'S'},
+    {"tab\there", 'S'},
+    {"new\nline", 'S'},
+    {"-1 -1 -1", 'S'},
+    {"kworker/u16:2-events_unbound", 'I'},
+};
+
+static std::string makeStatLine(unsigned tid, const char* comm, char state) {
+  char line[512];
+  snprintf(line, sizeof(line),
+           "%u (%s) %c 3860 3864 3860 0 -1 4194304 81 7 3 1 1234 567 89 10 20 0 1 0 106090 2703360 299 18446744073709551615 94470490361856 "
+           "94470490381737 140724004621504 0 0 0 0 0 0 0 0 0 17 0 0 0 0 0 0\n",
+           tid, comm, state);
+  return line;
+}
+
+static void checkFixture(const Fixture& fixture) {
+  auto line = makeStatLine(3864, fixture.comm, fixture.state);
+  cpu_monitor_LOGI("comm: [%s]", fixture.comm);
+
+  detail::TaskStat stat;  // NOLINT
+  ASSERT(stat.parse(line.data(), line.data() + line.size()));
+  ASSERT(stat.id == 3864);
+  ASSERT(strcmp(stat.name, fixture.comm) == 0);
+  ASSERT(stat.task_state == fixture.state);
+  ASSERT(stat.ppid == 3860);
+  ASSERT((int64_t)stat.tty_pgrp == -1);
+  ASSERT(stat.min_flt == 81);
+  ASSERT(stat.maj_flt == 3);
+  ASSERT(stat.utime == 1234);
+  ASSERT(stat.stime == 567);
+  ASSERT(stat.cutime == 89);
+  ASSERT(stat.cstime == 10);
+  ASSERT(stat.calcTicksTotal() == 1234 + 567 + 89 + 10);
+
+  ASSERT(stat.parse(line.data(), line.data() + line.size(), true));
+  ASSERT(stat.utime == 1234);
+  ASSERT(stat.num_threads == 1);
+  ASSERT(stat.start_time == 106090);
+  ASSERT(stat.vsize == 2703360);
+  ASSERT(stat.rss == 299);
+}
+
+static void checkMalformed() {
+  detail::TaskStat stat;  // NOLINT
+  const char* lines[] = {
+      "",
+      "3864",
+      "3864 (cpu_monitor",
+      "3864 (cpu_monitor) S 1 2",
+      "3864 cpu_monitor) S 1 2 3 4 5 6 7 8 9 10 11 12 13 14",
+  };
+  for (auto line : lines) {
+    ASSERT(!stat.parse(line, line + strlen(line)));
+  }
+  const char* truncated = "3864 (cpu_monitor) S 1 2 3 4 5 6 7 8 9 10 11 12 13 14 20 0 1 0";
+  ASSERT(stat.parse(truncated, truncated + strlen(truncated)));
+  ASSERT(!stat.parse(truncated, truncated + strlen(truncated), true));
+}
+
+static void checkLongName() {
+  std::string comm(100, 'x');
+  auto line = makeStatLine(1, comm.c_str(), 'S');
+  detail::TaskStat stat;  // NOLINT
+  ASSERT(stat.parse(line.data(), line.data() + line.size()));
+  ASSERT(strlen(stat.name) == sizeof(stat.name) - 1);
+  ASSERT(stat.utime == 1234);
+}
+
+int main() {
+  for (const auto& fixture : fixtures) {
+    checkFixture(fixture);
+  }
+  checkMalformed();
+  checkLongName();
+  cpu_monitor_LOGI("all passed");
+  return 0;
+}
@@ -0,0 +1,125 @@
+#include <cstdio>
+#include <vector>
+
+#include "ProcessTaskSampler.h"
+#include "TaskTable.h"
+#include "assert_def.h"
+#include "detail/log.h"
+
+using namespace cpu_monitor;
+
+static TaskSample makeSample(TaskId_t id, uint64_t cpuTimeNs) {
+  TaskSample sample{};
+  sample.id = id;
+  snprintf(sample.name, sizeof(sample.name), "task-%u", id);
+  sample.cpuTimeNs = cpuTimeNs;
+  return sample;
+}
+
+int main() {
+  TaskTable table;
+  std::vector<TaskId_t> births;
+  std::vector<TaskId_t> exits;
+  const auto onBirth = [&](const TaskSample& sample) {
+    births.push_back(sample.id);
+  };
+  const auto onExit = [&](const TaskTable::Row& row) {
+    exits.push_back(row.id);
+  };
+  const auto ids = [&] {
+    std::vector<TaskId_t> ret;
+    table.forEach([&](const TaskTable::Row& row) {
+      ret.push_back(row.id);
+    });
+    return ret;
+  };
+  const auto rowOf = [&](TaskId_t tid) {
+    auto i = table.find(tid);
+    ASSERT(i != TaskTable::NotFound);
+    return table.row(i);
+  };
+
+  // not sorted, as getdents64 may list them after tid wraps
+  std::vector<TaskSample> samples{makeSample(30, 0), makeSample(10, 0), makeSample(20, 0)};
+  table.update(samples, 0, onBirth, onExit);
+  ASSERT((births == std::vector<TaskId_t>{10, 20, 30}));
+  ASSERT(exits.empty());
+  ASSERT((ids() == std::vector<TaskId_t>{10, 20, 30}));
+  ASSERT(rowOf(20).id == 20);
+  ASSERT(rowOf(20).name == "task-20");
+  ASSERT(table.find(25) == TaskTable::NotFound);
+
+  // 20 exits, 25 and 40 are born, 10 and 30 are updated
+  births.clear();
+  samples = {makeSample(10, 500000000), makeSample(25, 0), makeSample(30, 1000000000), makeSample(40, 0)};
+  table.update(samples, 1000000000, onBirth, onExit);
+  ASSERT((births == std::vector<TaskId_t>{25, 40}));
+  ASSERT((exits == std::vector<TaskId_t>{20}));
+  ASSERT((ids() == std::vector<TaskId_t>{10, 25, 30, 40}));
+  ASSERT(table.rows() == 4);
+  ASSERT(rowOf(10).usage == 50);
+  ASSERT(rowOf(30).usage == 100);
+  ASSERT(rowOf(40).usage == 0);
+
+  // events between two updates
+  births.clear();
+  exits.clear();
+  ASSERT(table.insert(makeSample(35, 0)));
+  ASSERT(table.insert(makeSample(5, 0)));
+  ASSERT(!table.insert(makeSample(35, 0)));
+  table.erase(25);
+  table.erase(5);
+  table.erase(99);
+  ASSERT(table.find(25) == TaskTable::NotFound);
+  ASSERT(table.find(5) == TaskTable::NotFound);
+  ASSERT(rowOf(35).id == 35);
+  ASSERT((ids() == std::vector<TaskId_t>{10, 30, 40, 35}));
+
+  samples = {makeSample(10, 500000000), makeSample(30, 1000000000), makeSample(35, 100000000), makeSample(40, 0)};
+  table.update(samples, 1000000000, onBirth, onExit);
+  ASSERT(births.empty());
+  ASSERT(exits.empty());
+  ASSERT((ids() == std::vector<TaskId_t>{10, 30, 35, 40}));
+  ASSERT(table.rows() == 4);
+  ASSERT(rowOf(35).usage == 10);
+
+  // the process has exited
+  samples.clear();
+  table.update(samples, 1000000000, onBirth, onExit);
+  ASSERT((exits == std::vector<TaskId_t>{10, 30, 35, 40}));
+  ASSERT(table.rows() == 0);
+
+  // names are interned, renames are picked up
+  samples = {makeSample(10, 0), makeSample(20, 0)};
+  table.update(samples, 1000000000);
+  snprintf(samples[1].name, sizeof(samples[1].name), "renamed");
+  samples[0].cpuDelayNs = 3000;
+  table.update(samples, 1000000000);
+  ASSERT(rowOf(10).name == "task-10");
+  ASSERT(rowOf(20).name == "renamed");
+  ASSERT(rowOf(10).cpuDelayNs == 3000);
+
+  // event counts and delays during the interval, a reused tid counts from 0 again
+  samples[0].minFlt = 100;
+  samples[0].ctxSwitches = 50;
+  samples[0].cpuDelayNs = 8000000;
+  table.update(samples, 1000000000);
+  samples[0].minFlt = 160;
+  samples[0].ctxSwitches = 10;
+  samples[0].cpuDelayNs = 3000000;
+  table.update(samples, 1000000000);
+  ASSERT(rowOf(10).minFlt == 60);
+  ASSERT(rowOf(10).majFlt == 0);
+  ASSERT(rowOf(10).ctxSwitches == 10);
+  ASSERT(rowOf(10).cpuDelayNs == 3000000);
+
+  // cpu time going backwards is invalid data
+  samples[1].cpuTimeNs = 5000000000;
+  table.update(samples, 1000000000);
+  samples[1].cpuTimeNs = 0;
+  table.update(samples, 1000000000);
+  ASSERT(rowOf(20).usage == 0);
+
+  cpu_monitor_LOGI("all tests passed");
+  return 0;
+}
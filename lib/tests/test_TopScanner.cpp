@@ -0,0 +1,108 @@
+#include <signal.h>
+#include <sys/wait.h>
+#include <unistd.h>
+
+#include <algorithm>
+#include <atomic>
+#include <chrono>
+#include <thread>
+
+#include "TopScanner.h"
+#include "assert_def.h"
+#include "detail/log.h"
+
+using namespace cpu_monitor;
+
+static void busy(int ms) {
+  auto end = std::chrono::steady_clock::now() + std::chrono::milliseconds(ms);
+  while (std::chrono::steady_clock::now() < end) {
+  }
+}
+
+int main(int argc, char** argv) {
+  auto self = getpid();
+
+  // a single-threaded busy process
+  auto child = fork();
+  if (child == 0) {
+    // killed by the test, or by the alarm if the test aborts
+    alarm(30);
+    for (;;) {
+    }
+  }
+
+  // a busy thread and an idle one
+  std::atomic<bool> stop{false};
+  std::atomic<TaskId_t> busyTid{0};
+  std::thread busyThread([&] {
+    busyTid = (TaskId_t)gettid();
+    while (!stop) {
+    }
+  });
+  std::thread idleThread([&] {
+    while (!stop) std::this_thread::sleep_for(std::chrono::milliseconds(10));
+  });
+
+  TopScanner scanner(5);
+  cpu_monitor_LOGI("=> first scan takes the baseline");
+  ASSERT(scanner.scan());
+  cpu_monitor_LOGI("processes: %zu, threads: %zu", scanner.processes, scanner.threads);
+  ASSERT(scanner.processes > 1 && scanner.threads >= scanner.processes);
+  ASSERT(scanner.topCpu.empty() && scanner.topThreads.empty());
+  ASSERT(scanner.topRss.size() == 5);
+
+  cpu_monitor_LOGI("=> busy processes");
+  busy(200);
+  ASSERT(scanner.scan());
+  for (const auto& process : scanner.topCpu) {
+    cpu_monitor_LOGI("pid: %d, name: %s, usage: %.2f%%, rss: %lu kB, threads: %u", process.pid, process.name.c_str(), process.usage,
+                     (unsigned long)process.rss, process.threads);
+  }
+  ASSERT(scanner.topCpu.size() <= 5);
+  auto findProcess = [&](PID_t pid) {
+    return std::find_if(scanner.topCpu.cbegin(), scanner.topCpu.cend(), [&](const TopScanner::Process& process) {
+      return process.pid == pid;
+    });
+  };
+  ASSERT(findProcess(self) != scanner.topCpu.cend());
+  ASSERT(findProcess(self)->usage > 0 && findProcess(self)->threads == 3);
+  ASSERT(findProcess(child) != scanner.topCpu.cend());
+  ASSERT(std::is_sorted(scanner.topCpu.cbegin(), scanner.topCpu.cend(), [](const TopScanner::Process& a, const TopScanner::Process& b) {
+    return a.usage > b.usage;
+  }));
+  ASSERT(std::is_sorted(scanner.topRss.cbegin(), scanner.topRss.cend(), [](const TopScanner::Process& a, const TopScanner::Process& b) {
+    return a.rss > b.rss;
+  }));
+  // single-threaded processes are not read again
+  auto findThread = [&](TaskId_t tid) {
+    return std::find_if(scanner.topThreads.cbegin(), scanner.topThreads.cend(), [&](const TopScanner::Thread& thread) {
+      return thread.tid == tid;
+    });
+  };
+  ASSERT(findThread((TaskId_t)child) != scanner.topThreads.cend());
+  ASSERT(findThread(busyTid) == scanner.topThreads.cend());
+  ASSERT(scanner.threadsRead >= 3);
+
+  cpu_monitor_LOGI("=> busy threads");
+  busy(200);
+  ASSERT(scanner.scan());
+  for (const auto& thread : scanner.topThreads) {
+    cpu_monitor_LOGI("pid: %d, tid: %u, name: %s, usage: %.2f%%", thread.pid, thread.tid, thread.name.c_str(), thread.usage);
+  }
+  ASSERT(findThread(busyTid) != scanner.topThreads.cend());
+  ASSERT(findThread(busyTid)->pid == self && findThread(busyTid)->usage > 0);
+  ASSERT(findThread((TaskId_t)self) != scanner.topThreads.cend());
+  ASSERT(findThread((TaskId_t)child)->pid == child && findThread((TaskId_t)child)->usage > 0);
+
+  cpu_monitor_LOGI("=> exited processes are dropped");
+  kill(child, SIGKILL);
+  waitpid(child, nullptr, 0);
+  ASSERT(scanner.scan());
+  ASSERT(findProcess(child) == scanner.topCpu.cend());
+
+  stop = true;
+  busyThread.join();
+  idleThread.join();
+  cpu_monitor_LOGI("all tests passed");
+  return 0;
+}
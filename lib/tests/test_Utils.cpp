@@ -24,6 +24,8 @@ int main(int argc, char** argv) {
     cpu_monitor_LOGI("process name: %s", name.c_str());
     auto pid = Utils::getPidByName(name);
     cpu_monitor_LOGI("process pid: %d", pid);
+    // the name is longer than a comm, a lower pid may be another instance
+    ASSERT(pid > 0 && pid <= getpid());
   }
 
   return 0;
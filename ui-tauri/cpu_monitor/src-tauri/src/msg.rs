@@ -4,9 +4,17 @@ use serde::{Deserialize, Serialize};
 pub struct CpuInfo {
     pub name: String,
     pub usage: f32,
+    #[serde(default)]
+    pub times: Vec<u16>,
+    #[serde(default = "default_online")]
+    pub online: bool,
     pub timestamps: u64,
 }
 
+fn default_online() -> bool {
+    true
+}
+
 #[derive(Debug, Default, Serialize, Deserialize)]
 pub struct CpuMsg {
     pub ave: CpuInfo,
@@ -18,6 +26,24 @@ pub struct ThreadInfo {
     pub name: String,
     pub id: u64,
     pub usage: f32,
+    #[serde(default)]
+    pub latency: f32,
+    #[serde(default)]
+    pub min_flt: f32,
+    #[serde(default)]
+    pub maj_flt: f32,
+    #[serde(default)]
+    pub ctx_switches: f32,
+    #[serde(default)]
+    pub invol_ctx_switches: f32,
+    pub timestamps: u64,
+}
+
+#[derive(Debug, Default, Serialize, Deserialize)]
+pub struct ThreadEvent {
+    pub id: u64,
+    pub name: String,
+    pub exit: bool,
     pub timestamps: u64,
 }
 
@@ -27,6 +53,27 @@ pub struct MemInfo {
     pub size: u64,
     pub hwm: u64,
     pub rss: u64,
+    #[serde(default)]
+    pub pss: u64,
+    #[serde(default)]
+    pub uss: u64,
+    #[serde(default)]
+    pub rss_anon: u64,
+    #[serde(default)]
+    pub rss_file: u64,
+    #[serde(default)]
+    pub rss_shmem: u64,
+    #[serde(default)]
+    pub swap: u64,
+    pub timestamps: u64,
+}
+
+#[derive(Debug, Default, Serialize, Deserialize)]
+pub struct IoInfo {
+    pub rchar: f32,
+    pub wchar: f32,
+    pub read_bytes: f32,
+    pub write_bytes: f32,
     pub timestamps: u64,
 }
 
@@ -35,7 +82,11 @@ pub struct ProcessInfo {
     pub id: u64,
     pub name: String,
     pub thread_infos: Vec<ThreadInfo>,
+    #[serde(default)]
+    pub thread_events: Vec<ThreadEvent>,
     pub mem_info: MemInfo,
+    #[serde(default)]
+    pub io_info: IoInfo,
 }
 
 #[derive(Debug, Default, Serialize, Deserialize)]
@@ -55,11 +55,13 @@ impl MsgData {
                 msg.ave.timestamps = i;
                 msg.ave.name = "cpu".to_string();
                 msg.ave.usage = ((i as f32 / 10.0).sin() + 1.0) * 50.0;
+                msg.ave.online = true;
 
                 for j in 0..4 {
                     let mut c = CpuInfo::default();
                     c.name = format!("cpu{}", j);
                     c.usage = (((i + j * 10) as f32 / 10.0).sin() + 1.0) * 50.0;
+                    c.online = true;
                     c.timestamps = i;
                     msg.cores.push(c);
                 }
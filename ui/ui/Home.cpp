@@ -1,8 +1,10 @@
 #include "Home.h"
 
+#include <algorithm>
 #include <utility>
 
 #include "App.h"
+#include "BinaryMsg.h"
 #include "Common.h"
 #include "Types.h"
 #include "asio_net/rpc_client.hpp"
@@ -26,8 +28,11 @@ namespace flag {
 bool useLocal = true;
 bool showCpuAve = true;
 bool showCpuCores = true;
+bool showCpuTimes = true;
+int cpuCoresTimeType = -1;  // -1: usage
 bool showCpu = true;
 bool showMem = true;
+bool showIo = false;
 bool showTest = false;
 bool showLoadData = false;
 bool showSettings = false;
@@ -36,9 +41,47 @@ std::string serverPort = "8088";           // NOLINT
 }  // namespace flag
 }  // namespace ui
 
+// msg::CpuInfo::times, in the order of CpuT
+static const char* const CpuTimeNames[] = {"user", "nice", "system", "idle", "iowait", "irq", "softirq", "steal", "guest", "guest_nice"};
+static const int CpuTimeNum = sizeof(CpuTimeNames) / sizeof(CpuTimeNames[0]);
+static const int CpuTimeIdle = 3;
+
 // rpc
 static std::unique_ptr<asio_net::rpc_client> s_rpc_client;
 static std::shared_ptr<rpc_core::rpc> s_rpc;
+static msg::binary::Decoder s_binary_decoder;
+// set_encoding is sent, the frames fail to decode until its key frame arrives
+static bool s_key_frame_requested = false;
+
+static void requestBinaryEncoding() {
+  s_key_frame_requested = true;
+  s_rpc->cmd("set_encoding")
+      ->msg(std::string("binary"))
+      ->rsp([](const std::string& msg) {
+        // old servers have no set_encoding and keep sending json
+        LOGI("set_encoding rsp: %s", msg.c_str());
+      })
+      ->timeout([] {
+        s_key_frame_requested = false;
+      })
+      ->call();
+}
+
+/**
+ * @return false if the frame can not be decoded, a key frame is requested once then
+ */
+template <typename Msg>
+static bool decodeBinary(const std::string& frame, Msg* msg) {
+  if (s_binary_decoder.decode(frame, msg)) {
+    s_key_frame_requested = false;
+    return true;
+  }
+  if (!s_key_frame_requested) {
+    LOGW("decode binary msg failed, request a key frame");
+    requestBinaryEncoding();
+  }
+  return false;
+}
 
 static void initRpc() {
   s_rpc = rpc_core::rpc::create();
@@ -53,6 +96,22 @@ static void initRpc() {
     if (ui::flag::showLoadData) return;
     s_msg.process(std::move(msg));
   });
+
+  s_rpc->subscribe("on_cpu_bin", [](const std::string& frame) {
+    msg::CpuMsg msg;
+    if (!decodeBinary(frame, &msg)) return;
+    if (ui::flag::showTest) return;
+    if (ui::flag::showLoadData) return;
+    s_msg.process(std::move(msg));
+  });
+
+  s_rpc->subscribe("on_process_bin", [](const std::string& frame) {
+    msg::ProcessMsg msg;
+    if (!decodeBinary(frame, &msg)) return;
+    if (ui::flag::showTest) return;
+    if (ui::flag::showLoadData) return;
+    s_msg.process(std::move(msg));
+  });
 }
 
 static void initClient() {
@@ -64,6 +123,7 @@ static void initClient() {
   auto& client = s_rpc_client;
   client->on_open = [](const std::shared_ptr<rpc_core::rpc>& rpc) {
     LOGI("on_open");
+    requestBinaryEncoding();
   };
   client->on_open_failed = [](const std::error_code& ec) {
     LOGI("on_open_failed: %s", ec.message().c_str());
@@ -123,6 +183,9 @@ void Home::onDraw() {
   ImGui::SameLine();
   ImGui::Checkbox("Ave##Show Ave", &ui::flag::showCpuAve);
 
+  ImGui::SameLine();
+  ImGui::Checkbox("Times##Show Times", &ui::flag::showCpuTimes);
+
   ImGui::SameLine();
   ImGui::Checkbox("Cores##Show Cores", &ui::flag::showCpuCores);
 
@@ -132,6 +195,9 @@ void Home::onDraw() {
   ImGui::SameLine();
   ImGui::Checkbox("MEM##Show MEM", &ui::flag::showMem);
 
+  ImGui::SameLine();
+  ImGui::Checkbox("IO##Show IO", &ui::flag::showIo);
+
   static auto calcTimestampsFromStart = [](uint64_t timestamps) -> double {
     return double(timestamps - s_msg_cpus.front().ave.timestamps) / 1000;
   };
@@ -352,10 +418,50 @@ void Home::onDraw() {
     ImPlot::EndPlot();
   }
 
+  // ave times, one line per category except idle
+  if (ui::flag::showCpuTimes && ImPlot::BeginPlot("CPU Ave Times (%/sec)")) {
+    const int axisXMin = 10;
+    ImPlot::SetupAxesLimits(0, axisXMin, 0, 100);
+
+    ImPlot::SetupAxes("Time(sec)", "CPU(%)", ImPlotAxisFlags_AutoFit, ImPlotAxisFlags_Lock);
+    ImPlot::SetupLegend(ImPlotLocation_NorthWest);
+    if (!s_msg_cpus.empty()) {
+      for (int type = 0; type < CpuTimeNum; ++type) {
+        if (type == CpuTimeIdle) continue;
+        static int typeNow;
+        typeNow = type;
+        ImPlot::PlotLineG(
+            CpuTimeNames[type],
+            (ImPlotGetter)[](int idx, void* user_data) {
+              auto& info = s_msg_cpus[idx].ave;
+              return ImPlotPoint{calcTimestampsFromStart(info.timestamps), info.time(typeNow)};
+            },
+            nullptr, (int)s_msg_cpus.size());
+      }
+    }
+    ImPlot::EndPlot();
+  }
+
   // cores
+  if (ui::flag::showCpuCores) {
+    ImGui::PushItemWidth(100);
+    const char* preview = ui::flag::cpuCoresTimeType < 0 ? "usage" : CpuTimeNames[ui::flag::cpuCoresTimeType];
+    if (ImGui::BeginCombo("##Cores Time Type", preview)) {
+      if (ImGui::Selectable("usage", ui::flag::cpuCoresTimeType < 0)) ui::flag::cpuCoresTimeType = -1;
+      for (int type = 0; type < CpuTimeNum; ++type) {
+        if (ImGui::Selectable(CpuTimeNames[type], ui::flag::cpuCoresTimeType == type)) ui::flag::cpuCoresTimeType = type;
+      }
+      ImGui::EndCombo();
+    }
+    ImGui::PopItemWidth();
+  }
   std::string coreInfo = []() -> std::string {
     if (s_msg_cpus.empty()) return "";
-    return " cores: " + std::to_string(s_msg_cpus.front().cores.size());
+    auto& cores = s_msg_cpus.back().cores;
+    auto online = std::count_if(cores.begin(), cores.end(), [](const msg::CpuInfo& info) {
+      return info.online;
+    });
+    return " cores: " + std::to_string(online) + "/" + std::to_string(cores.size());
   }();
   if (ui::flag::showCpuCores && ImPlot::BeginPlot(("Cpu Cores Usages (%/sec)" + coreInfo).c_str())) {
     const int axisXMin = 10;
@@ -363,16 +469,22 @@ void Home::onDraw() {
 
     ImPlot::SetupAxes("Time(sec)", "CPU(%)", ImPlotAxisFlags_AutoFit | ImPlotAxisFlags_NoLabel, ImPlotAxisFlags_Lock);
     if (!s_msg_cpus.empty()) {
-      const uint32_t cpuCores = s_msg_cpus.front().cores.size();
+      // cores are indexed by id and only added, older msgs may have less of them
+      auto& lastCores = s_msg_cpus.back().cores;
+      const uint32_t cpuCores = lastCores.size();
       ImPlot::SetupLegend(ImPlotLocation_NorthWest, ImPlotLegendFlags_None);
       for (uint32_t i = 0; i < cpuCores; ++i) {
         static uint32_t indexNow;
         indexNow = i;
+        auto& name = lastCores[i].name;
         ImPlot::PlotLineG(
-            s_msg_cpus.front().cores[indexNow].name.c_str(),
+            (name + (lastCores[i].online ? "" : " (offline)") + "##" + name).c_str(),
             (ImPlotGetter)[](int idx, void* user_data) {
-              auto& info = s_msg_cpus[idx].cores[indexNow];
-              return ImPlotPoint{calcTimestampsFromStart(info.timestamps), info.usage};
+              auto& msg = s_msg_cpus[idx];
+              if (indexNow >= msg.cores.size()) return ImPlotPoint{calcTimestampsFromStart(msg.ave.timestamps), 0};
+              auto& info = msg.cores[indexNow];
+              auto type = ui::flag::cpuCoresTimeType;
+              return ImPlotPoint{calcTimestampsFromStart(info.timestamps), type < 0 ? info.usage : info.time(type)};
             },
             nullptr, (int)s_msg_cpus.size());
       }
@@ -460,6 +572,54 @@ void Home::onDraw() {
               return ImPlotPoint{calcTimestampsFromStart(info.timestamps), (float)info.rss / 1024};
             },
             nullptr, (int)memInfos->size());
+
+        // only sampled with `-m`
+        if (memInfos->back().pss != 0) {
+          snprintf(label_tmp, sizeof(label_tmp), "PSS: %.2fMB USS: %.2fMB", (float)memInfos->back().pss / 1024, (float)memInfos->back().uss / 1024);
+          ImPlot::PlotLineG(
+              label_tmp,
+              (ImPlotGetter)[](int idx, void* user_data) {
+                auto& info = (*memInfos)[idx];
+                return ImPlotPoint{calcTimestampsFromStart(info.timestamps), (float)info.pss / 1024};
+              },
+              nullptr, (int)memInfos->size());
+        }
+        ImPlot::EndPlot();
+      }
+
+      // plot io info
+      if (ui::flag::showIo && !msgPid.second.io_infos.empty()) {
+        const static decltype(msgPid.second.io_infos)* ioInfos;
+        ioInfos = &(msgPid.second.io_infos);
+
+        auto plotName = "pid: " + std::to_string(processKey) + " name: " + processValue.name + " IO/KB/sec";
+        if (!ImPlot::BeginPlot(plotName.c_str())) {
+          break;
+        }
+
+        const int axisXMin = 10;
+        ImPlot::SetupAxesLimits(0, axisXMin, 0, 100);
+        ImPlot::SetupAxes("Time(sec)", "IO(KB/sec)", ImPlotAxisFlags_NoLabel | ImPlotAxisFlags_AutoFit, ImPlotAxisFlags_AutoFit);
+        ImPlot::SetupLegend(ImPlotLocation_NorthWest, ImPlotLegendFlags_None);
+
+        // rchar, wchar, read_bytes, write_bytes
+        static const char* const IoNames[] = {"rchar", "wchar", "read_bytes", "write_bytes"};
+        for (int i = 0; i < 4; ++i) {
+          static int typeNow;
+          typeNow = i;
+          char label_tmp[64];
+          auto& last = ioInfos->back();
+          const float values[] = {last.rchar, last.wchar, last.read_bytes, last.write_bytes};
+          snprintf(label_tmp, sizeof(label_tmp), "%s: %.1fKB/s", IoNames[i], values[i] / 1024);
+          ImPlot::PlotLineG(
+              label_tmp,
+              (ImPlotGetter)[](int idx, void* user_data) {
+                auto& info = (*ioInfos)[idx];
+                const float values[] = {info.rchar, info.wchar, info.read_bytes, info.write_bytes};
+                return ImPlotPoint{calcTimestampsFromStart(info.timestamps), values[typeNow] / 1024};
+              },
+              nullptr, (int)ioInfos->size());
+        }
         ImPlot::EndPlot();
       }
     }
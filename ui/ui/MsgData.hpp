@@ -20,9 +20,10 @@ struct ProcessValue {
   std::string name;
   std::vector<ThreadInfoItem> thread_infos;
   std::vector<msg::MemInfo> mem_infos;
+  std::vector<msg::IoInfo> io_infos;
   uint64_t max_rss = 0;
 };
-NLOHMANN_DEFINE_TYPE_NON_INTRUSIVE(ProcessValue, thread_infos, mem_infos, max_rss);
+NLOHMANN_DEFINE_TYPE_NON_INTRUSIVE_WITH_DEFAULT(ProcessValue, thread_infos, mem_infos, io_infos, max_rss);
 
 struct MsgData {
   std::vector<msg::CpuMsg> msg_cpus;
@@ -45,6 +46,8 @@ struct MsgData {
         msg.ave.timestamps = i;
         msg.ave.name = "cpu";
         msg.ave.usage = (sin((float)i / 10) + 1) * 50;
+        float aveTimes[] = {msg.ave.usage * 0.6f, 0, msg.ave.usage * 0.3f, 100 - msg.ave.usage, msg.ave.usage * 0.1f};
+        msg.ave.setTimes(aveTimes, sizeof(aveTimes) / sizeof(aveTimes[0]));
 
         for (int j = 0; j < 4; ++j) {
           msg::CpuInfo c;
@@ -90,6 +93,9 @@ struct MsgData {
       processValue.name = pInfo.name;
       processValue.mem_infos.push_back(pInfo.mem_info);
       processValue.max_rss = std::max(processValue.max_rss, pInfo.mem_info.rss);
+
+      // io info
+      processValue.io_infos.push_back(pInfo.io_info);
     }
   }
 };